@@ -59,6 +59,8 @@ struct disk {
 
 	long long read_cnt;         /* Number of sectors read. */
 	long long write_cnt;        /* Number of sectors written. */
+	long long read_cmd_cnt;     /* Number of read commands issued. */
+	long long write_cmd_cnt;    /* Number of write commands issued. */
 };
 
 /* An ATA channel (aka controller).
@@ -84,7 +86,7 @@ static void reset_channel (struct channel *);
 static bool check_device_type (struct disk *);
 static void identify_ata_device (struct disk *);
 
-static void select_sector (struct disk *, disk_sector_t);
+static void select_sector (struct disk *, disk_sector_t, size_t cnt);
 static void issue_pio_command (struct channel *, uint8_t command);
 static void input_sector (struct channel *, void *);
 static void output_sector (struct channel *, const void *);
@@ -134,6 +136,7 @@ disk_init (void) {
 			d->capacity = 0;
 
 			d->read_cnt = d->write_cnt = 0;
+			d->read_cmd_cnt = d->write_cmd_cnt = 0;
 		}
 
 		/* Register interrupt handler. */
@@ -167,8 +170,10 @@ disk_print_stats (void) {
 		for (dev_no = 0; dev_no < 2; dev_no++) {
 			struct disk *d = disk_get (chan_no, dev_no);
 			if (d != NULL && d->is_ata)
-				printf ("%s: %lld reads, %lld writes\n",
-						d->name, d->read_cnt, d->write_cnt);
+				printf ("%s: %lld reads, %lld writes, %lld read commands, "
+						"%lld write commands\n",
+						d->name, d->read_cnt, d->write_cnt,
+						d->read_cmd_cnt, d->write_cmd_cnt);
 		}
 	}
 }
@@ -209,21 +214,9 @@ disk_size (struct disk *d) {
    per-disk locking is unneeded. */
 void
 disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
-	struct channel *c;
-
-	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	struct disk_seg seg = { buffer, 1 };
 
-	c = d->channel;
-	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
-	sema_down (&c->completion_wait);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name, sec_no);
-	input_sector (c, buffer);
-	d->read_cnt++;
-	lock_release (&c->lock);
+	disk_readv (d, sec_no, &seg, 1);
 }
 
 /* Write sector SEC_NO to disk D from BUFFER, which must contain
@@ -233,23 +226,104 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
    per-disk locking is unneeded. */
 void
 disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
+	struct disk_seg seg = { (void *) buffer, 1 };
+
+	disk_writev (d, sec_no, &seg, 1);
+}
+
+/* Reads consecutive sectors starting at SEC_NO from disk D into
+   the SEG_CNT buffers of SEGS, filling each with its CNT sectors
+   in order.  Up to DISK_XFER_MAX sectors are moved per command,
+   so a run costs one command and one channel lock acquisition
+   rather than one per sector. */
+void
+disk_readv (struct disk *d, disk_sector_t sec_no,
+		const struct disk_seg *segs, size_t seg_cnt) {
 	struct channel *c;
+	size_t seg = 0, ofs = 0;
 
 	ASSERT (d != NULL);
-	ASSERT (buffer != NULL);
+	ASSERT (segs != NULL);
 
 	c = d->channel;
 	lock_acquire (&c->lock);
-	select_sector (d, sec_no);
-	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
-	if (!wait_while_busy (d))
-		PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name, sec_no);
-	output_sector (c, buffer);
-	sema_down (&c->completion_wait);
-	d->write_cnt++;
+	while (seg < seg_cnt) {
+		size_t cnt = 0, i;
+		size_t s, o;
+
+		/* Count sectors left, up to the per-command limit. */
+		for (s = seg, o = ofs; s < seg_cnt && cnt < DISK_XFER_MAX; cnt++)
+			if (++o >= segs[s].cnt) {
+				s++;
+				o = 0;
+			}
+
+		select_sector (d, sec_no, cnt);
+		issue_pio_command (c, CMD_READ_SECTOR_RETRY);
+		for (i = 0; i < cnt; i++) {
+			sema_down (&c->completion_wait);
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk read failed, sector=%"PRDSNu, d->name,
+						sec_no + (disk_sector_t) i);
+			input_sector (c, (uint8_t *) segs[seg].buffer
+					+ ofs * DISK_SECTOR_SIZE);
+			if (++ofs >= segs[seg].cnt) {
+				seg++;
+				ofs = 0;
+			}
+		}
+		d->read_cnt += cnt;
+		d->read_cmd_cnt++;
+		sec_no += cnt;
+	}
 	lock_release (&c->lock);
 }
-
+
+/* Writes consecutive sectors starting at SEC_NO to disk D from
+   the SEG_CNT buffers of SEGS, as disk_readv().  Returns after
+   the disk has acknowledged receiving all of the data. */
+void
+disk_writev (struct disk *d, disk_sector_t sec_no,
+		const struct disk_seg *segs, size_t seg_cnt) {
+	struct channel *c;
+	size_t seg = 0, ofs = 0;
+
+	ASSERT (d != NULL);
+	ASSERT (segs != NULL);
+
+	c = d->channel;
+	lock_acquire (&c->lock);
+	while (seg < seg_cnt) {
+		size_t cnt = 0, i;
+		size_t s, o;
+
+		for (s = seg, o = ofs; s < seg_cnt && cnt < DISK_XFER_MAX; cnt++)
+			if (++o >= segs[s].cnt) {
+				s++;
+				o = 0;
+			}
+
+		select_sector (d, sec_no, cnt);
+		issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
+		for (i = 0; i < cnt; i++) {
+			if (!wait_while_busy (d))
+				PANIC ("%s: disk write failed, sector=%"PRDSNu, d->name,
+						sec_no + (disk_sector_t) i);
+			output_sector (c, (uint8_t *) segs[seg].buffer
+					+ ofs * DISK_SECTOR_SIZE);
+			sema_down (&c->completion_wait);
+			if (++ofs >= segs[seg].cnt) {
+				seg++;
+				ofs = 0;
+			}
+		}
+		d->write_cnt += cnt;
+		d->write_cmd_cnt++;
+		sec_no += cnt;
+	}
+	lock_release (&c->lock);
+}
+
 /* Disk detection and identification. */
 
 static void print_ata_string (char *string, size_t size);
@@ -402,17 +476,19 @@ print_ata_string (char *string, size_t size) {
 }
 
 /* Selects device D, waiting for it to become ready, and then
-   writes SEC_NO to the disk's sector selection registers.  (We
-   use LBA mode.) */
+   writes SEC_NO and the sector count CNT to the disk's sector
+   selection registers.  (We use LBA mode.)  A count register of
+   0 means DISK_XFER_MAX sectors. */
 static void
-select_sector (struct disk *d, disk_sector_t sec_no) {
+select_sector (struct disk *d, disk_sector_t sec_no, size_t cnt) {
 	struct channel *c = d->channel;
 
-	ASSERT (sec_no < d->capacity);
-	ASSERT (sec_no < (1UL << 28));
+	ASSERT (cnt > 0 && cnt <= DISK_XFER_MAX);
+	ASSERT (sec_no + cnt <= d->capacity);
+	ASSERT (sec_no + cnt <= (1UL << 28));
 
 	select_device_wait (d);
-	outb (reg_nsect (c), 1);
+	outb (reg_nsect (c), cnt == DISK_XFER_MAX ? 0 : cnt);
 	outb (reg_lbal (c), sec_no);
 	outb (reg_lbam (c), sec_no >> 8);
 	outb (reg_lbah (c), (sec_no >> 16));
@@ -0,0 +1,379 @@
+#include "filesys/cache.h"
+#include <debug.h>
+#include <hash.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+
+/* Sector buffer cache.
+ *
+ * Every sector the file system reads or writes goes through a cache of
+ * CACHE_SIZE sectors.  Writes only dirty the cached copy; dirty sectors
+ * go to disk when they are evicted, every CACHE_FLUSH_TICKS timer ticks
+ * from the bcflushd thread, and at cache_done().  Replacement is
+ * second-chance clock.
+ *
+ * Sectors a sequential reader is expected to want next are read in the
+ * background by the bcreadd thread, from a queue filled by
+ * cache_readahead().  They enter the cache unreferenced, so read-ahead
+ * that is never used is the first to be evicted.
+ *
+ * CACHE_LOCK protects the entries and is held across disk I/O, but not
+ * while data is copied to or from a caller's buffer, which may be user
+ * memory and fault.  An entry is pinned for the length of that copy so
+ * it cannot be evicted meanwhile. */
+
+/* Ticks between write-behind passes. */
+#define CACHE_FLUSH_TICKS TIMER_FREQ
+/* Read-ahead requests that may be queued at once. */
+#define CACHE_RA_QUEUE 64
+
+/* A cached sector. */
+struct cache_entry {
+	disk_sector_t sector;               /* Cached sector, if VALID. */
+	bool valid;                         /* Holds a sector? */
+	bool dirty;                         /* Newer than the disk copy? */
+	bool accessed;                      /* Used since the hand passed? */
+	bool filling;                       /* Being overwritten whole, not
+	                                       read from disk first. */
+	bool readahead;                     /* Read ahead, not yet used. */
+	unsigned pin_cnt;                   /* Copies in progress. */
+	struct hash_elem elem;              /* Element in cache_map. */
+	uint8_t data[DISK_SECTOR_SIZE];     /* Sector contents. */
+};
+
+size_t cache_size = CACHE_SIZE_DEFAULT;
+
+static struct cache_entry *cache;       /* CACHE_SIZE entries. */
+static struct hash cache_map;           /* Valid entries by sector. */
+static size_t cache_hand;               /* Clock hand. */
+static struct lock cache_lock;
+static struct condition cache_changed;  /* An entry was unpinned or
+                                           filled. */
+
+static disk_sector_t ra_queue[CACHE_RA_QUEUE];  /* Sectors to read ahead. */
+static size_t ra_head;
+static size_t ra_cnt;
+static struct semaphore ra_wakeup;      /* Read-ahead was queued. */
+
+/* Statistics. */
+static unsigned long long cache_hits;
+static unsigned long long cache_misses;
+static unsigned long long cache_disk_reads;
+static unsigned long long cache_disk_writes;
+static unsigned long long cache_readaheads;
+static unsigned long long cache_readahead_hits;
+
+static hash_hash_func cache_hash;
+static hash_less_func cache_less;
+static void cache_flushd (void *aux);
+static void cache_readd (void *aux);
+
+/* Initializes the buffer cache and starts its write-behind thread. */
+void
+cache_init (void) {
+	if (cache_size == 0)
+		cache_size = 1;
+	cache = calloc (cache_size, sizeof *cache);
+	if (cache == NULL || !hash_init (&cache_map, cache_hash, cache_less, NULL))
+		PANIC ("buffer cache allocation failed (%zu sectors)", cache_size);
+	lock_init (&cache_lock);
+	cond_init (&cache_changed);
+	sema_init (&ra_wakeup, 0);
+
+	if (thread_create ("bcflushd", PRI_DEFAULT, cache_flushd, NULL)
+			== TID_ERROR)
+		PANIC ("failed to start buffer cache flush thread");
+	if (thread_create ("bcreadd", PRI_DEFAULT, cache_readd, NULL)
+			== TID_ERROR)
+		PANIC ("failed to start buffer cache read-ahead thread");
+}
+
+static uint64_t
+cache_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct cache_entry *ce = hash_entry (e, struct cache_entry, elem);
+	return hash_int (ce->sector);
+}
+
+static bool
+cache_less (const struct hash_elem *a, const struct hash_elem *b,
+		void *aux UNUSED) {
+	return hash_entry (a, struct cache_entry, elem)->sector
+		< hash_entry (b, struct cache_entry, elem)->sector;
+}
+
+/* Returns the entry holding SECTOR, or a null pointer.
+ * CACHE_LOCK must be held. */
+static struct cache_entry *
+cache_lookup (disk_sector_t sector) {
+	struct cache_entry key;
+	struct hash_elem *e;
+
+	key.sector = sector;
+	e = hash_find (&cache_map, &key.elem);
+	return e != NULL ? hash_entry (e, struct cache_entry, elem) : NULL;
+}
+
+/* Returns the valid entry for SECTOR, waiting while it is being filled,
+ * or a null pointer.  CACHE_LOCK must be held. */
+static struct cache_entry *
+cache_lookup_filled (disk_sector_t sector) {
+	struct cache_entry *ce;
+
+	while ((ce = cache_lookup (sector)) != NULL && ce->filling)
+		cond_wait (&cache_changed, &cache_lock);
+	return ce;
+}
+
+/* Writes ENTRY to disk if it is dirty.  CACHE_LOCK must be held. */
+static void
+cache_writeback (struct cache_entry *ce) {
+	if (ce->valid && ce->dirty && !ce->filling) {
+		ce->dirty = false;
+		disk_write (filesys_disk, ce->sector, ce->data);
+		cache_disk_writes++;
+	}
+}
+
+/* Frees an entry for a new sector, writing back the one it held if
+ * needed, and returns it.  Waits while every entry is pinned.
+ * CACHE_LOCK must be held. */
+static struct cache_entry *
+cache_evict (void) {
+	for (;;) {
+		size_t n;
+
+		for (n = 0; n < 2 * cache_size; n++) {
+			struct cache_entry *ce = &cache[cache_hand];
+			cache_hand = (cache_hand + 1) % cache_size;
+
+			if (ce->pin_cnt > 0)
+				continue;
+			if (ce->valid && ce->accessed) {
+				ce->accessed = false;
+				continue;
+			}
+			if (ce->valid) {
+				cache_writeback (ce);
+				hash_delete (&cache_map, &ce->elem);
+				ce->valid = false;
+			}
+			return ce;
+		}
+		cond_wait (&cache_changed, &cache_lock);
+	}
+}
+
+/* Returns the entry for SECTOR, pinned, loading it on a miss.  If
+ * WHOLE, the caller is about to overwrite the entire sector, so a miss
+ * does not read the disk; the entry is hidden from other users until
+ * cache_put(). */
+static struct cache_entry *
+cache_get (disk_sector_t sector, bool whole) {
+	struct cache_entry *ce;
+
+	lock_acquire (&cache_lock);
+	ce = cache_lookup_filled (sector);
+	if (ce != NULL) {
+		cache_hits++;
+		if (ce->readahead)
+			cache_readahead_hits++;
+	} else {
+		cache_misses++;
+		ce = cache_evict ();
+		ce->sector = sector;
+		ce->valid = true;
+		ce->dirty = false;
+		ce->filling = whole;
+		hash_insert (&cache_map, &ce->elem);
+		if (!whole) {
+			disk_read (filesys_disk, sector, ce->data);
+			cache_disk_reads++;
+		}
+	}
+	ce->accessed = true;
+	ce->readahead = false;
+	ce->pin_cnt++;
+	lock_release (&cache_lock);
+	return ce;
+}
+
+/* Unpins CE, marking it dirty if DIRTY. */
+static void
+cache_put (struct cache_entry *ce, bool dirty) {
+	lock_acquire (&cache_lock);
+	if (dirty)
+		ce->dirty = true;
+	ce->filling = false;
+	ce->pin_cnt--;
+	cond_broadcast (&cache_changed, &cache_lock);
+	lock_release (&cache_lock);
+}
+
+/* Reads SIZE bytes at offset OFS of SECTOR into BUFFER. */
+void
+cache_read (disk_sector_t sector, void *buffer, off_t ofs, size_t size) {
+	struct cache_entry *ce;
+
+	ASSERT (ofs >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	ce = cache_get (sector, false);
+	memcpy (buffer, ce->data + ofs, size);
+	cache_put (ce, false);
+}
+
+/* Writes SIZE bytes from BUFFER at offset OFS of SECTOR.  The disk is
+ * updated later. */
+void
+cache_write (disk_sector_t sector, const void *buffer, off_t ofs,
+		size_t size) {
+	struct cache_entry *ce;
+
+	ASSERT (ofs >= 0 && ofs + size <= DISK_SECTOR_SIZE);
+
+	ce = cache_get (sector, ofs == 0 && size == DISK_SECTOR_SIZE);
+	memcpy (ce->data + ofs, buffer, size);
+	cache_put (ce, true);
+}
+
+/* Reads SECTOR into BUFFER, a whole sector, for a caller that keeps its
+ * own copy of the data, such as the page cache.  The cached copy is used
+ * if there is one; otherwise the disk is read and nothing is cached. */
+void
+cache_read_direct (disk_sector_t sector, void *buffer) {
+	struct cache_entry *ce;
+
+	lock_acquire (&cache_lock);
+	ce = cache_lookup_filled (sector);
+	if (ce != NULL)
+		memcpy (buffer, ce->data, DISK_SECTOR_SIZE);
+	else {
+		disk_read (filesys_disk, sector, buffer);
+		cache_disk_reads++;
+	}
+	lock_release (&cache_lock);
+}
+
+/* Writes BUFFER, a whole sector, to SECTOR, bypassing the cache unless
+ * it already holds the sector, in which case the cached copy is updated
+ * instead so the two cannot disagree. */
+void
+cache_write_direct (disk_sector_t sector, const void *buffer) {
+	struct cache_entry *ce;
+
+	lock_acquire (&cache_lock);
+	ce = cache_lookup_filled (sector);
+	if (ce != NULL) {
+		memcpy (ce->data, buffer, DISK_SECTOR_SIZE);
+		ce->dirty = true;
+	} else {
+		disk_write (filesys_disk, sector, buffer);
+		cache_disk_writes++;
+	}
+	lock_release (&cache_lock);
+}
+
+/* Asks for SECTOR to be read into the cache in the background, unless it
+ * is cached or queued already.  The request is dropped if the queue is
+ * full. */
+void
+cache_readahead (disk_sector_t sector) {
+	bool queued = false;
+	size_t i;
+
+	lock_acquire (&cache_lock);
+	if (cache_lookup (sector) == NULL && ra_cnt < CACHE_RA_QUEUE) {
+		queued = true;
+		for (i = 0; i < ra_cnt; i++)
+			if (ra_queue[(ra_head + i) % CACHE_RA_QUEUE] == sector)
+				queued = false;
+		if (queued)
+			ra_queue[(ra_head + ra_cnt++) % CACHE_RA_QUEUE] = sector;
+	}
+	lock_release (&cache_lock);
+
+	if (queued)
+		sema_up (&ra_wakeup);
+}
+
+/* Writes every dirty sector to disk. */
+void
+cache_flush (void) {
+	size_t i;
+
+	lock_acquire (&cache_lock);
+	for (i = 0; i < cache_size; i++)
+		cache_writeback (&cache[i]);
+	lock_release (&cache_lock);
+}
+
+/* Writes back the cache before shutdown. */
+void
+cache_done (void) {
+	cache_flush ();
+}
+
+/* Write-behind thread. */
+static void
+cache_flushd (void *aux UNUSED) {
+	for (;;) {
+		timer_sleep (CACHE_FLUSH_TICKS);
+		cache_flush ();
+	}
+}
+
+/* Read-ahead thread.  Loads queued sectors that are still missing. */
+static void
+cache_readd (void *aux UNUSED) {
+	for (;;) {
+		sema_down (&ra_wakeup);
+
+		/* One sector per hold of CACHE_LOCK, so that readers waiting for
+		   the disk themselves are not held up behind the whole queue. */
+		lock_acquire (&cache_lock);
+		while (ra_cnt > 0) {
+			disk_sector_t sector = ra_queue[ra_head];
+			ra_head = (ra_head + 1) % CACHE_RA_QUEUE;
+			ra_cnt--;
+
+			if (cache_lookup (sector) == NULL) {
+				struct cache_entry *ce = cache_evict ();
+				ce->sector = sector;
+				ce->valid = true;
+				ce->dirty = false;
+				ce->accessed = false;
+				ce->filling = false;
+				ce->readahead = true;
+				hash_insert (&cache_map, &ce->elem);
+				disk_read (filesys_disk, sector, ce->data);
+				cache_disk_reads++;
+				cache_readaheads++;
+			}
+			lock_release (&cache_lock);
+			lock_acquire (&cache_lock);
+		}
+		lock_release (&cache_lock);
+	}
+}
+
+/* Adds the buffer cache's hits, misses and hits on sectors read ahead
+ * so far to *HITS, *MISSES and *RA_HITS. */
+void
+cache_get_stats (uint64_t *hits, uint64_t *misses, uint64_t *ra_hits) {
+	*hits += cache_hits;
+	*misses += cache_misses;
+	*ra_hits += cache_readahead_hits;
+}
+
+/* Prints buffer cache statistics. */
+void
+cache_print_stats (void) {
+	printf ("Buffer cache: %llu hits, %llu misses, %llu read ahead, "
+			"%llu disk reads, %llu disk writes\n",
+			cache_hits, cache_misses, cache_readaheads, cache_disk_reads,
+			cache_disk_writes);
+}
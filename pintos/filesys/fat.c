@@ -1,4 +1,5 @@
 #include "filesys/fat.h"
+#include <bitmap.h>
 #include "devices/disk.h"
 #include "filesys/filesys.h"
 #include "threads/malloc.h"
@@ -16,7 +17,17 @@ struct fat_boot {
 	unsigned int root_dir_cluster;
 };
 
-/* FAT FS */
+/* FAT FS
+ *
+ * Besides the FAT itself, the in-memory state keeps an index of which
+ * clusters are in use, one bit per FAT entry.  Allocation is next-fit:
+ * the search for a free cluster starts where the previous one left off,
+ * so over a sequence of allocations each bit is passed about once rather
+ * than the FAT being rescanned from the start every time.  A chain being
+ * stretched takes the cluster right after its tail if that is free.
+ *
+ * FAT sectors changed since the FAT was loaded are tracked as well, and
+ * fat_close() writes back only those. */
 struct fat_fs {
 	struct fat_boot bs;
 	unsigned int *fat;
@@ -24,12 +35,21 @@ struct fat_fs {
 	disk_sector_t data_start;
 	cluster_t last_clst;
 	struct lock write_lock;
+	struct bitmap *used;      /* Clusters in use, one bit per entry. */
+	struct bitmap *dirty;     /* FAT sectors to write back. */
+	cluster_t next_clst;      /* Where the next search starts. */
+	size_t free_cnt;          /* Free clusters. */
 };
 
+/* FAT entries per sector. */
+#define FAT_PER_SECTOR (DISK_SECTOR_SIZE / sizeof (cluster_t))
+
 static struct fat_fs *fat_fs;
 
 void fat_boot_create (void);
 void fat_fs_init (void);
+static void fat_index_init (void);
+static void fat_set (cluster_t clst, cluster_t val);
 
 void
 fat_init (void) {
@@ -53,6 +73,7 @@ fat_init (void) {
 
 void
 fat_open (void) {
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT load failed");
@@ -78,6 +99,7 @@ fat_open (void) {
 			free (bounce);
 		}
 	}
+	fat_index_init ();
 }
 
 void
@@ -90,24 +112,23 @@ fat_close (void) {
 	disk_write (filesys_disk, FAT_BOOT_SECTOR, bounce);
 	free (bounce);
 
-	// Write FAT directly to the disk
+	// Write changed FAT sectors directly to the disk
 	uint8_t *buffer = (uint8_t *) fat_fs->fat;
-	off_t bytes_wrote = 0;
-	off_t bytes_left = sizeof (fat_fs->fat);
 	const off_t fat_size_in_bytes = fat_fs->fat_length * sizeof (cluster_t);
 	for (unsigned i = 0; i < fat_fs->bs.fat_sectors; i++) {
-		bytes_left = fat_size_in_bytes - bytes_wrote;
+		off_t ofs = (off_t) i * DISK_SECTOR_SIZE;
+		off_t bytes_left = fat_size_in_bytes - ofs;
+		if (!bitmap_test (fat_fs->dirty, i))
+			continue;
+		bitmap_reset (fat_fs->dirty, i);
 		if (bytes_left >= DISK_SECTOR_SIZE) {
-			disk_write (filesys_disk, fat_fs->bs.fat_start + i,
-			            buffer + bytes_wrote);
-			bytes_wrote += DISK_SECTOR_SIZE;
+			disk_write (filesys_disk, fat_fs->bs.fat_start + i, buffer + ofs);
 		} else {
 			bounce = calloc (1, DISK_SECTOR_SIZE);
 			if (bounce == NULL)
 				PANIC ("FAT close failed");
-			memcpy (bounce, buffer + bytes_wrote, bytes_left);
+			memcpy (bounce, buffer + ofs, bytes_left);
 			disk_write (filesys_disk, fat_fs->bs.fat_start + i, bounce);
-			bytes_wrote += bytes_left;
 			free (bounce);
 		}
 	}
@@ -120,9 +141,13 @@ fat_create (void) {
 	fat_fs_init ();
 
 	// Create FAT table
+	free (fat_fs->fat);
 	fat_fs->fat = calloc (fat_fs->fat_length, sizeof (cluster_t));
 	if (fat_fs->fat == NULL)
 		PANIC ("FAT creation failed");
+	fat_index_init ();
+	// The whole table is new, so all of it goes to disk
+	bitmap_set_all (fat_fs->dirty, true);
 
 	// Set up ROOT_DIR_CLST
 	fat_put (ROOT_DIR_CLUSTER, EOChain);
@@ -152,42 +177,162 @@ fat_boot_create (void) {
 
 void
 fat_fs_init (void) {
-	/* TODO: Your code goes here. */
+	unsigned int data_sectors;
+
+	fat_fs->data_start = fat_fs->bs.fat_start + fat_fs->bs.fat_sectors;
+	data_sectors = fat_fs->bs.total_sectors - fat_fs->data_start;
+
+	/* Entry 0 is reserved, so cluster N is the (N - 1)th data cluster.
+	 * The table cannot outgrow the FAT sectors on disk. */
+	fat_fs->fat_length = data_sectors / SECTORS_PER_CLUSTER + 1;
+	if (fat_fs->fat_length > fat_fs->bs.fat_sectors * FAT_PER_SECTOR)
+		fat_fs->fat_length = fat_fs->bs.fat_sectors * FAT_PER_SECTOR;
+	fat_fs->last_clst = fat_fs->fat_length - 1;
+	lock_init (&fat_fs->write_lock);
+}
+
+/* (Re)builds the free-cluster index from the FAT in memory.  Nothing is
+ * dirty afterwards. */
+static void
+fat_index_init (void) {
+	cluster_t clst;
+
+	bitmap_destroy (fat_fs->used);
+	bitmap_destroy (fat_fs->dirty);
+	fat_fs->used = bitmap_create (fat_fs->fat_length);
+	fat_fs->dirty = bitmap_create (fat_fs->bs.fat_sectors);
+	if (fat_fs->used == NULL || fat_fs->dirty == NULL)
+		PANIC ("FAT index creation failed");
+
+	bitmap_mark (fat_fs->used, 0);
+	fat_fs->free_cnt = 0;
+	for (clst = 1; clst < fat_fs->fat_length; clst++)
+		if (fat_fs->fat[clst] != 0)
+			bitmap_mark (fat_fs->used, clst);
+		else
+			fat_fs->free_cnt++;
+	fat_fs->next_clst = ROOT_DIR_CLUSTER;
 }
 
 /*----------------------------------------------------------------------------*/
 /* FAT handling                                                               */
 /*----------------------------------------------------------------------------*/
 
+/* Sets FAT entry CLST to VAL, keeping the free-cluster index and the
+ * dirty sectors up to date.  WRITE_LOCK must be held, except while the
+ * file system is being set up. */
+static void
+fat_set (cluster_t clst, cluster_t val) {
+	bool was_used, used;
+
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+
+	was_used = fat_fs->fat[clst] != 0;
+	used = val != 0;
+	if (was_used != used) {
+		bitmap_set (fat_fs->used, clst, used);
+		if (used)
+			fat_fs->free_cnt--;
+		else
+			fat_fs->free_cnt++;
+	}
+	fat_fs->fat[clst] = val;
+	bitmap_mark (fat_fs->dirty, clst / FAT_PER_SECTOR);
+}
+
+/* Finds CNT consecutive free clusters and returns the first, or 0 if
+ * there is no such run.  The run right after HINT is preferred; after
+ * that the search is next-fit.  WRITE_LOCK must be held. */
+static cluster_t
+fat_find_run (cluster_t hint, size_t cnt) {
+	size_t start;
+
+	if (cnt == 0 || cnt > fat_fs->free_cnt)
+		return 0;
+	if (hint != 0 && hint + cnt < fat_fs->fat_length
+			&& bitmap_none (fat_fs->used, hint + 1, cnt))
+		return hint + 1;
+
+	start = bitmap_scan (fat_fs->used, fat_fs->next_clst, cnt, false);
+	if (start == BITMAP_ERROR)
+		start = bitmap_scan (fat_fs->used, 1, cnt, false);
+	return start != BITMAP_ERROR ? start : 0;
+}
+
+/* Allocates a run of CNT consecutive clusters, chains them together and
+ * appends them to the chain ending at CLST, or starts a new chain if CLST
+ * is 0.  The run directly after CLST is used when it is free, so a file
+ * that grows a cluster at a time stays contiguous on disk.
+ * Returns the first new cluster, or 0 if no run of CNT clusters is
+ * free. */
+cluster_t
+fat_create_run (cluster_t clst, size_t cnt) {
+	cluster_t start;
+	size_t i;
+
+	lock_acquire (&fat_fs->write_lock);
+	start = fat_find_run (clst, cnt);
+	if (start != 0) {
+		for (i = 0; i + 1 < cnt; i++)
+			fat_set (start + i, start + i + 1);
+		fat_set (start + cnt - 1, EOChain);
+		if (clst != 0)
+			fat_set (clst, start);
+		fat_fs->next_clst = start + cnt < fat_fs->fat_length
+			? start + cnt : 1;
+	}
+	lock_release (&fat_fs->write_lock);
+	return start;
+}
+
 /* Add a cluster to the chain.
  * If CLST is 0, start a new chain.
  * Returns 0 if fails to allocate a new cluster. */
 cluster_t
 fat_create_chain (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	return fat_create_run (clst, 1);
 }
 
 /* Remove the chain of clusters starting from CLST.
  * If PCLST is 0, assume CLST as the start of the chain. */
 void
 fat_remove_chain (cluster_t clst, cluster_t pclst) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	if (pclst != 0)
+		fat_set (pclst, EOChain);
+	while (clst != 0 && clst != EOChain) {
+		cluster_t next = fat_fs->fat[clst];
+		fat_set (clst, 0);
+		clst = next;
+	}
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Update a value in the FAT table. */
 void
 fat_put (cluster_t clst, cluster_t val) {
-	/* TODO: Your code goes here. */
+	lock_acquire (&fat_fs->write_lock);
+	fat_set (clst, val);
+	lock_release (&fat_fs->write_lock);
 }
 
 /* Fetch a value in the FAT table. */
 cluster_t
 fat_get (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+	return fat_fs->fat[clst];
 }
 
 /* Covert a cluster # to a sector number. */
 disk_sector_t
 cluster_to_sector (cluster_t clst) {
-	/* TODO: Your code goes here. */
+	ASSERT (clst >= 1 && clst < fat_fs->fat_length);
+	return fat_fs->data_start + (clst - 1) * SECTORS_PER_CLUSTER;
+}
+
+/* Convert a sector # to the cluster # that holds it. */
+cluster_t
+sector_to_cluster (disk_sector_t sector) {
+	ASSERT (sector >= fat_fs->data_start);
+	return (sector - fat_fs->data_start) / SECTORS_PER_CLUSTER + 1;
 }
@@ -5,12 +5,19 @@
 #include "filesys/inode.h"
 #include "threads/malloc.h"
 
+/* Read-ahead window bounds, in bytes. */
+#define READAHEAD_MIN 2048
+#define READAHEAD_MAX 16384
+
 /* An open file. */
 struct file {
   struct inode *inode; /* File's inode. */
   off_t pos;           /* Current position. */
   bool deny_write;     /* Has file_deny_write() been called? */
   int ref_count;       /* Reference count. */
+  off_t ra_next;       /* Where a sequential read would start next. */
+  off_t ra_window;     /* Read-ahead window, 0 if access is random. */
+  off_t ra_end;        /* End of what was read ahead so far. */
 };
 
 /* Opens a file for the given INODE, of which it takes ownership,
@@ -60,13 +67,45 @@ void file_close(struct file *file) {
 /* Returns the inode encapsulated by FILE. */
 struct inode *file_get_inode(struct file *file) { return file->inode; }
 
+/* Updates FILE's read-ahead state for a read of SIZE bytes at POS and
+ * starts reading ahead of it.  A read that starts where the last one
+ * ended doubles the window, up to READAHEAD_MAX; any other read closes
+ * it.  While it is open, the window's worth of data past the read is kept
+ * on its way into memory, so the next read finds it there. */
+static void file_readahead(struct file *file, off_t pos, off_t size) {
+  if (pos == file->ra_next) {
+    // 순차 접근: window를 키움
+    if (file->ra_window == 0) {
+      file->ra_window = READAHEAD_MIN;
+    } else if (file->ra_window < READAHEAD_MAX) {
+      file->ra_window *= 2;
+    }
+  } else {
+    // 임의 접근: 미리 읽기 중단
+    file->ra_window = 0;
+    file->ra_end = pos;
+  }
+  file->ra_next = pos + size;
+  if (file->ra_window == 0) return;
+
+  // 이번 read가 끝난 곳부터 window만큼 앞서 읽어 둠 (이미 요청한 부분은 제외)
+  off_t start = file->ra_end > pos + size ? file->ra_end : pos + size;
+  off_t end = pos + size + file->ra_window;
+  if (start < end) {
+    inode_readahead(file->inode, start, end - start);
+    file->ra_end = end;
+  }
+}
+
 /* Reads SIZE bytes from FILE into BUFFER,
  * starting at the file's current position.
  * Returns the number of bytes actually read,
  * which may be less than SIZE if end of file is reached.
- * Advances FILE's position by the number of bytes read. */
+ * Advances FILE's position by the number of bytes read.
+ * Sequential reads are detected and read ahead of. */
 off_t file_read(struct file *file, void *buffer, off_t size) {
   off_t bytes_read = inode_read_at(file->inode, buffer, size, file->pos);
+  file_readahead(file, file->pos, bytes_read);
   file->pos += bytes_read;
   return bytes_read;
 }
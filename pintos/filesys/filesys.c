@@ -5,11 +5,15 @@
 #include <string.h>
 
 #include "devices/disk.h"
+#include "filesys/cache.h"
 #include "filesys/directory.h"
 #include "filesys/file.h"
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "threads/synch.h"
+#if defined(VM) && defined(EFILESYS)
+#include "filesys/page_cache.h"
+#endif
 
 // filesys_lock 정의
 struct lock filesys_lock;
@@ -26,6 +30,7 @@ void filesys_init(bool format) {
   if (filesys_disk == NULL)
     PANIC("hd0:1 (hdb) not present, file system initialization failed");
 
+  cache_init();
   inode_init();
 
 #ifdef EFILESYS
@@ -54,10 +59,14 @@ void filesys_init(bool format) {
 void filesys_done(void) {
   /* Original FS */
 #ifdef EFILESYS
+#ifdef VM
+  page_cache_flush();
+#endif
   fat_close();
 #else
   free_map_close();
 #endif
+  cache_done();
 }
 
 /* Creates a file named NAME with the given INITIAL_SIZE.
@@ -67,10 +76,10 @@ void filesys_done(void) {
 bool filesys_create(const char *name, off_t initial_size) {
   disk_sector_t inode_sector = 0;
   struct dir *dir = dir_open_root();
-  bool success = (dir != NULL && free_map_allocate(1, &inode_sector) &&
+  bool success = (dir != NULL && inode_sector_allocate(&inode_sector) &&
                   inode_create(inode_sector, initial_size) &&
                   dir_add(dir, name, inode_sector));
-  if (!success && inode_sector != 0) free_map_release(inode_sector, 1);
+  if (!success && inode_sector != 0) inode_sector_release(inode_sector);
   dir_close(dir);
 
   return success;
@@ -110,6 +119,7 @@ static void do_format(void) {
 #ifdef EFILESYS
   /* Create FAT and save it to the disk. */
   fat_create();
+  if (!dir_create(ROOT_DIR_SECTOR, 16)) PANIC("root directory creation failed");
   fat_close();
 #else
   free_map_create();
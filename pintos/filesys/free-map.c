@@ -36,6 +36,33 @@ free_map_allocate (size_t cnt, disk_sector_t *sectorp) {
 	return sector != BITMAP_ERROR;
 }
 
+/* Allocates up to CNT free sectors that start exactly at SECTOR, so that
+ * a run of sectors ending just before SECTOR can be extended in place.
+ * Returns the number of sectors allocated, which is 0 if SECTOR itself
+ * is in use. */
+size_t
+free_map_extend (disk_sector_t sector, size_t cnt) {
+	size_t end;
+
+	if (sector >= bitmap_size (free_map) || cnt == 0)
+		return 0;
+
+	end = bitmap_scan (free_map, sector, 1, true);
+	if (end == BITMAP_ERROR)
+		end = bitmap_size (free_map);
+	if (end - sector < cnt)
+		cnt = end - sector;
+	if (cnt == 0)
+		return 0;
+
+	bitmap_set_multiple (free_map, sector, cnt, true);
+	if (free_map_file != NULL && !bitmap_write (free_map, free_map_file)) {
+		bitmap_set_multiple (free_map, sector, cnt, false);
+		return 0;
+	}
+	return cnt;
+}
+
 /* Makes CNT sectors starting at SECTOR available for use. */
 void
 free_map_release (disk_sector_t sector, size_t cnt) {
@@ -3,20 +3,56 @@
 #include <debug.h>
 #include <round.h>
 #include <string.h>
+#include "filesys/cache.h"
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
+#ifdef EFILESYS
+#include "filesys/fat.h"
+#endif
 #include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#ifdef VM
+#include "vm/vm.h"
+#endif
+#if defined (VM) && defined (EFILESYS)
+#include "filesys/page_cache.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
 
+/* A run of consecutive sectors of file data. */
+struct extent {
+	disk_sector_t start;                /* First sector. */
+	uint32_t length;                    /* Number of sectors. */
+};
+
+/* Extents stored in the inode itself and in its indirect block. */
+#define INODE_EXTENTS 62
+#define INDIRECT_EXTENTS (DISK_SECTOR_SIZE / sizeof (struct extent))
+#define MAX_EXTENTS (INODE_EXTENTS + INDIRECT_EXTENTS)
+
 /* On-disk inode.
- * Must be exactly DISK_SECTOR_SIZE bytes long. */
+ * Must be exactly DISK_SECTOR_SIZE bytes long.
+ *
+ * File data is a list of extents, in file order.  The first
+ * INODE_EXTENTS are kept here and the rest in a single indirect block.
+ * Sectors past the end of the last extent are not allocated yet; the
+ * extents may also run past LENGTH, after a write that could only be
+ * partly satisfied. */
 struct inode_disk {
-	disk_sector_t start;                /* First data sector. */
 	off_t length;                       /* File size in bytes. */
 	unsigned magic;                     /* Magic number. */
-	uint32_t unused[125];               /* Not used. */
+	uint32_t extent_cnt;                /* Number of extents. */
+	disk_sector_t indirect;             /* Sector of the indirect block, if
+	                                       EXTENT_CNT > INODE_EXTENTS. */
+	struct extent extents[INODE_EXTENTS];   /* Leading extents. */
+};
+
+/* Indirect block: extents past the first INODE_EXTENTS. */
+struct extent_block {
+	struct extent extents[INDIRECT_EXTENTS];
 };
 
 /* Returns the number of sectors to allocate for an inode SIZE
@@ -34,19 +70,253 @@ struct inode {
 	bool removed;                       /* True if deleted, false otherwise. */
 	int deny_write_cnt;                 /* 0: writes ok, >0: deny writes. */
 	struct inode_disk data;             /* Inode content. */
+	struct extent_block *indirect;      /* Indirect block, or null. */
+	size_t sectors;                     /* Sectors in all extents. */
+	struct lock extent_lock;            /* Protects the extents and hint. */
+	size_t hint;                        /* Extent of the last lookup. */
+	size_t hint_base;                   /* File sector HINT starts at. */
 };
 
+/* Returns extent IDX of INODE. */
+static struct extent *
+inode_extent (struct inode *inode, size_t idx) {
+	ASSERT (idx < MAX_EXTENTS);
+	if (idx < INODE_EXTENTS)
+		return &inode->data.extents[idx];
+	return &inode->indirect->extents[idx - INODE_EXTENTS];
+}
+
 /* Returns the disk sector that contains byte offset POS within
  * INODE.
  * Returns -1 if INODE does not contain data for a byte at offset
- * POS. */
+ * POS.
+ *
+ * The search starts from the extent the previous lookup ended in, so a
+ * sequential reader finds its sector there or in the next extent. */
 static disk_sector_t
-byte_to_sector (const struct inode *inode, off_t pos) {
+byte_to_sector (struct inode *inode, off_t pos) {
+	disk_sector_t sector = -1;
+	size_t idx, i, base;
+
 	ASSERT (inode != NULL);
-	if (pos < inode->data.length)
-		return inode->data.start + pos / DISK_SECTOR_SIZE;
-	else
+	if (pos >= inode->data.length)
 		return -1;
+
+	idx = pos / DISK_SECTOR_SIZE;
+	lock_acquire (&inode->extent_lock);
+	i = inode->hint;
+	base = inode->hint_base;
+	if (idx < base) {
+		i = 0;
+		base = 0;
+	}
+	for (; i < inode->data.extent_cnt; i++) {
+		const struct extent *e = inode_extent (inode, i);
+		if (idx < base + e->length) {
+			sector = e->start + (idx - base);
+			inode->hint = i;
+			inode->hint_base = base;
+			break;
+		}
+		base += e->length;
+	}
+	lock_release (&inode->extent_lock);
+	return sector;
+}
+
+/* Writes INODE's extent IDX, and the extent count, to disk. */
+static void
+inode_store_extent (struct inode *inode, size_t idx) {
+	cache_write (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	if (idx >= INODE_EXTENTS)
+		cache_write (inode->data.indirect, inode->indirect, 0,
+				DISK_SECTOR_SIZE);
+}
+
+/* Allocates one sector for an inode or an indirect block and stores it
+ * in *SECTORP.  With the FAT file system the sector is a cluster in a
+ * chain of its own.  Returns false if the disk is full. */
+bool
+inode_sector_allocate (disk_sector_t *sectorp) {
+#ifdef EFILESYS
+	cluster_t clst = fat_create_chain (0);
+	if (clst == 0)
+		return false;
+	*sectorp = cluster_to_sector (clst);
+	return true;
+#else
+	return free_map_allocate (1, sectorp);
+#endif
+}
+
+/* Frees SECTOR, allocated by inode_sector_allocate(). */
+void
+inode_sector_release (disk_sector_t sector) {
+#ifdef EFILESYS
+	fat_remove_chain (sector_to_cluster (sector), 0);
+#else
+	free_map_release (sector, 1);
+#endif
+}
+
+/* Fills CNT sectors starting at SECTOR with zeros. */
+static void
+zero_sectors (disk_sector_t sector, size_t cnt) {
+	static char zeros[DISK_SECTOR_SIZE];
+	size_t i;
+
+	for (i = 0; i < cnt; i++)
+		cache_write (sector + i, zeros, 0, DISK_SECTOR_SIZE);
+}
+
+/* Allocates up to CNT sectors to follow LAST, the last extent of a
+ * file's data (null if there is none yet), stores the first in *SECTORP
+ * and returns how many were allocated, 0 if the disk is full.  The
+ * sectors right after LAST are taken when they are free; otherwise the
+ * longest run up to CNT found by halving the request.
+ * With the FAT file system the run is appended to the file's cluster
+ * chain with fat_create_run(), so the chain lists all of the file's data
+ * in file order. */
+static size_t
+data_allocate (const struct extent *last, size_t cnt,
+		disk_sector_t *sectorp) {
+#ifdef EFILESYS
+	cluster_t tail = 0;
+
+	if (last != NULL)
+		tail = sector_to_cluster (last->start + last->length - 1);
+	for (; cnt > 0; cnt /= 2) {
+		cluster_t clst = fat_create_run (tail, cnt);
+		if (clst != 0) {
+			*sectorp = cluster_to_sector (clst);
+			break;
+		}
+	}
+	return cnt;
+#else
+	if (last != NULL) {
+		size_t got = free_map_extend (last->start + last->length, cnt);
+		if (got > 0) {
+			*sectorp = last->start + last->length;
+			return got;
+		}
+	}
+	for (; cnt > 0; cnt /= 2)
+		if (free_map_allocate (cnt, sectorp))
+			break;
+	return cnt;
+#endif
+}
+
+/* Frees the CNT sectors at SECTOR that data_allocate() just added after
+ * LAST. */
+static void
+data_release (const struct extent *last UNUSED, disk_sector_t sector,
+		size_t cnt UNUSED) {
+#ifdef EFILESYS
+	cluster_t tail = 0;
+
+	if (last != NULL)
+		tail = sector_to_cluster (last->start + last->length - 1);
+	fat_remove_chain (sector_to_cluster (sector), tail);
+#else
+	free_map_release (sector, cnt);
+#endif
+}
+
+/* Adds between 1 and CNT zeroed sectors to the end of INODE's data.
+ * The last extent is stretched in place when data_allocate() returns the
+ * sectors right after it, so that a file grown piece by piece stays
+ * contiguous; otherwise a new extent is started.
+ * Returns false if no sector could be added. */
+static bool
+inode_add_sectors (struct inode *inode, size_t cnt) {
+	size_t extent_cnt = inode->data.extent_cnt;
+	struct extent *last = NULL;
+	disk_sector_t start;
+	size_t got;
+
+	if (extent_cnt > 0)
+		last = inode_extent (inode, extent_cnt - 1);
+	got = data_allocate (last, cnt, &start);
+	if (got == 0)
+		return false;
+
+	if (last != NULL && start == last->start + last->length) {
+		zero_sectors (start, got);
+		lock_acquire (&inode->extent_lock);
+		last->length += got;
+		lock_release (&inode->extent_lock);
+		inode_store_extent (inode, extent_cnt - 1);
+	} else {
+		struct extent *e;
+
+		if (extent_cnt == MAX_EXTENTS) {
+			data_release (last, start, got);
+			return false;
+		}
+		if (extent_cnt == INODE_EXTENTS && inode->indirect == NULL) {
+			struct extent_block *indirect = calloc (1, sizeof *indirect);
+			if (indirect == NULL
+					|| !inode_sector_allocate (&inode->data.indirect)) {
+				free (indirect);
+				data_release (last, start, got);
+				return false;
+			}
+			inode->indirect = indirect;
+		}
+		zero_sectors (start, got);
+
+		lock_acquire (&inode->extent_lock);
+		e = inode_extent (inode, extent_cnt);
+		e->start = start;
+		e->length = got;
+		inode->data.extent_cnt++;
+		lock_release (&inode->extent_lock);
+		inode_store_extent (inode, extent_cnt);
+	}
+	inode->sectors += got;
+	return true;
+}
+
+/* Extends INODE to LENGTH bytes, allocating sectors as needed.  New
+ * bytes read as zeros.
+ * Returns false if the disk or the extent list ran out first, in which
+ * case the length is unchanged. */
+static bool
+inode_grow (struct inode *inode, off_t length) {
+	size_t sectors = bytes_to_sectors (length);
+
+	while (inode->sectors < sectors)
+		if (!inode_add_sectors (inode, sectors - inode->sectors))
+			return false;
+
+	if (length > inode->data.length) {
+		inode->data.length = length;
+		cache_write (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+	}
+	return true;
+}
+
+/* Frees all of INODE's data sectors and its indirect block.  With the
+ * FAT file system the data is a single chain and goes at once. */
+static void
+inode_release_blocks (struct inode *inode) {
+#ifdef EFILESYS
+	if (inode->data.extent_cnt > 0)
+		fat_remove_chain (sector_to_cluster (inode_extent (inode, 0)->start), 0);
+#else
+	size_t i;
+
+	for (i = 0; i < inode->data.extent_cnt; i++) {
+		const struct extent *e = inode_extent (inode, i);
+		free_map_release (e->start, e->length);
+	}
+#endif
+	if (inode->data.extent_cnt > INODE_EXTENTS)
+		inode_sector_release (inode->data.indirect);
+	inode->data.extent_cnt = 0;
+	inode->sectors = 0;
 }
 
 /* List of open inodes, so that opening a single inode twice
@@ -67,6 +337,7 @@ inode_init (void) {
 bool
 inode_create (disk_sector_t sector, off_t length) {
 	struct inode_disk *disk_inode = NULL;
+	struct inode *inode;
 	bool success = false;
 
 	ASSERT (length >= 0);
@@ -74,24 +345,22 @@ inode_create (disk_sector_t sector, off_t length) {
 	/* If this assertion fails, the inode structure is not exactly
 	 * one sector in size, and you should fix that. */
 	ASSERT (sizeof *disk_inode == DISK_SECTOR_SIZE);
+	ASSERT (sizeof (struct extent_block) == DISK_SECTOR_SIZE);
 
+	/* Write an empty inode, then grow it to LENGTH. */
 	disk_inode = calloc (1, sizeof *disk_inode);
-	if (disk_inode != NULL) {
-		size_t sectors = bytes_to_sectors (length);
-		disk_inode->length = length;
-		disk_inode->magic = INODE_MAGIC;
-		if (free_map_allocate (sectors, &disk_inode->start)) {
-			disk_write (filesys_disk, sector, disk_inode);
-			if (sectors > 0) {
-				static char zeros[DISK_SECTOR_SIZE];
-				size_t i;
-
-				for (i = 0; i < sectors; i++) 
-					disk_write (filesys_disk, disk_inode->start + i, zeros); 
-			}
-			success = true; 
-		} 
-		free (disk_inode);
+	if (disk_inode == NULL)
+		return false;
+	disk_inode->magic = INODE_MAGIC;
+	cache_write (sector, disk_inode, 0, DISK_SECTOR_SIZE);
+	free (disk_inode);
+
+	inode = inode_open (sector);
+	if (inode != NULL) {
+		success = inode_grow (inode, length);
+		if (!success)
+			inode_release_blocks (inode);
+		inode_close (inode);
 	}
 	return success;
 }
@@ -103,6 +372,7 @@ struct inode *
 inode_open (disk_sector_t sector) {
 	struct list_elem *e;
 	struct inode *inode;
+	size_t i;
 
 	/* Check whether this inode is already open. */
 	for (e = list_begin (&open_inodes); e != list_end (&open_inodes);
@@ -120,12 +390,31 @@ inode_open (disk_sector_t sector) {
 		return NULL;
 
 	/* Initialize. */
-	list_push_front (&open_inodes, &inode->elem);
 	inode->sector = sector;
 	inode->open_cnt = 1;
 	inode->deny_write_cnt = 0;
 	inode->removed = false;
-	disk_read (filesys_disk, inode->sector, &inode->data);
+	inode->indirect = NULL;
+	inode->sectors = 0;
+	inode->hint = 0;
+	inode->hint_base = 0;
+	lock_init (&inode->extent_lock);
+	cache_read (inode->sector, &inode->data, 0, DISK_SECTOR_SIZE);
+
+	/* Load the extents past the inline ones. */
+	if (inode->data.extent_cnt > INODE_EXTENTS) {
+		inode->indirect = malloc (sizeof *inode->indirect);
+		if (inode->indirect == NULL) {
+			free (inode);
+			return NULL;
+		}
+		cache_read (inode->data.indirect, inode->indirect, 0,
+				DISK_SECTOR_SIZE);
+	}
+	for (i = 0; i < inode->data.extent_cnt; i++)
+		inode->sectors += inode_extent (inode, i)->length;
+
+	list_push_front (&open_inodes, &inode->elem);
 	return inode;
 }
 
@@ -157,13 +446,18 @@ inode_close (struct inode *inode) {
 		/* Remove from inode list and release lock. */
 		list_remove (&inode->elem);
 
+#if defined (VM) && defined (EFILESYS)
+		/* Write back and drop the cached pages of the file. */
+		page_cache_drop (inode, inode->removed);
+#endif
+
 		/* Deallocate blocks if removed. */
 		if (inode->removed) {
-			free_map_release (inode->sector, 1);
-			free_map_release (inode->data.start,
-					bytes_to_sectors (inode->data.length)); 
+			inode_sector_release (inode->sector);
+			inode_release_blocks (inode);
 		}
 
+		free (inode->indirect);
 		free (inode); 
 	}
 }
@@ -183,7 +477,11 @@ off_t
 inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 	uint8_t *buffer = buffer_;
 	off_t bytes_read = 0;
-	uint8_t *bounce = NULL;
+
+#if defined (VM) && defined (EFILESYS)
+	/* File data is cached in pages rather than in sectors. */
+	return page_cache_read (inode, buffer_, size, offset);
+#endif
 
 	while (size > 0) {
 		/* Disk sector to read, starting byte offset within sector. */
@@ -200,46 +498,61 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) {
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Read full sector directly into caller's buffer. */
-			disk_read (filesys_disk, sector_idx, buffer + bytes_read); 
-		} else {
-			/* Read sector into bounce buffer, then partially copy
-			 * into caller's buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-			disk_read (filesys_disk, sector_idx, bounce);
-			memcpy (buffer + bytes_read, bounce + sector_ofs, chunk_size);
-		}
+		/* Copy out of the buffer cache. */
+		cache_read (sector_idx, buffer + bytes_read, sector_ofs, chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_read += chunk_size;
 	}
-	free (bounce);
 
 	return bytes_read;
 }
 
+/* Starts reading the SIZE bytes of INODE at OFFSET into memory in the
+ * background, for a reader expected to ask for them soon.  Bytes past
+ * the end of the file are ignored. */
+void
+inode_readahead (struct inode *inode, off_t offset, off_t size) {
+	off_t end = offset + size;
+	off_t pos;
+
+	if (end > inode_length (inode))
+		end = inode_length (inode);
+
+#if defined (VM) && defined (EFILESYS)
+	for (pos = ROUND_DOWN (offset, PGSIZE); pos < end; pos += PGSIZE)
+		page_cache_prefetch (inode, pos);
+#else
+	for (pos = ROUND_DOWN (offset, DISK_SECTOR_SIZE); pos < end;
+			pos += DISK_SECTOR_SIZE)
+		cache_readahead (byte_to_sector (inode, pos));
+#endif
+}
+
 /* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET.
+ * A write past end of file extends the inode first.
  * Returns the number of bytes actually written, which may be
- * less than SIZE if end of file is reached or an error occurs.
- * (Normally a write at end of file would extend the inode, but
- * growth is not yet implemented.) */
+ * less than SIZE if the inode cannot be extended that far or an
+ * error occurs. */
 off_t
 inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		off_t offset) {
 	const uint8_t *buffer = buffer_;
 	off_t bytes_written = 0;
-	uint8_t *bounce = NULL;
 
 	if (inode->deny_write_cnt)
 		return 0;
 
+	/* Grow the file.  If that fails, write as much as fits. */
+	if (size > 0 && offset + size > inode_length (inode))
+		inode_grow (inode, offset + size);
+
+#if defined (VM) && defined (EFILESYS)
+	return page_cache_write (inode, buffer_, size, offset);
+#endif
+
 	while (size > 0) {
 		/* Sector to write, starting byte offset within sector. */
 		disk_sector_t sector_idx = byte_to_sector (inode, offset);
@@ -255,38 +568,65 @@ inode_write_at (struct inode *inode, const void *buffer_, off_t size,
 		if (chunk_size <= 0)
 			break;
 
-		if (sector_ofs == 0 && chunk_size == DISK_SECTOR_SIZE) {
-			/* Write full sector directly to disk. */
-			disk_write (filesys_disk, sector_idx, buffer + bytes_written); 
-		} else {
-			/* We need a bounce buffer. */
-			if (bounce == NULL) {
-				bounce = malloc (DISK_SECTOR_SIZE);
-				if (bounce == NULL)
-					break;
-			}
-
-			/* If the sector contains data before or after the chunk
-			   we're writing, then we need to read in the sector
-			   first.  Otherwise we start with a sector of all zeros. */
-			if (sector_ofs > 0 || chunk_size < sector_left) 
-				disk_read (filesys_disk, sector_idx, bounce);
-			else
-				memset (bounce, 0, DISK_SECTOR_SIZE);
-			memcpy (bounce + sector_ofs, buffer + bytes_written, chunk_size);
-			disk_write (filesys_disk, sector_idx, bounce); 
-		}
+		/* Copy into the buffer cache, which reads the rest of a
+		   partially written sector and writes it back later. */
+		cache_write (sector_idx, buffer + bytes_written, sector_ofs, chunk_size);
 
 		/* Advance. */
 		size -= chunk_size;
 		offset += chunk_size;
 		bytes_written += chunk_size;
 	}
-	free (bounce);
 
+#ifdef VM
+	/* Frames read before the write must not be mapped again. */
+	vm_file_written (inode, offset - bytes_written, bytes_written);
+#endif
 	return bytes_written;
 }
 
+/* Reads the page of INODE at OFS, which is page-aligned, into KVA for
+ * the page cache.  The page cache keeps the only cached copy, so sectors
+ * are not brought into the buffer cache.  Bytes past the end of the file
+ * read as zeros. */
+void
+inode_read_page (struct inode *inode, off_t ofs, void *kva) {
+	uint8_t *page = kva;
+	off_t length = inode_length (inode) - ofs;
+	off_t pos;
+
+	ASSERT (ofs % PGSIZE == 0);
+
+	for (pos = 0; pos < PGSIZE; pos += DISK_SECTOR_SIZE) {
+		if (pos < length)
+			cache_read_direct (byte_to_sector (inode, ofs + pos), page + pos);
+		else
+			memset (page + pos, 0, DISK_SECTOR_SIZE);
+	}
+	if (length > 0 && length < PGSIZE)
+		memset (page + length, 0, ROUND_UP (length, DISK_SECTOR_SIZE) - length);
+}
+
+/* Writes the first SIZE bytes of the page at KVA to INODE at OFS, which
+ * is page-aligned, bypassing the buffer cache.  SIZE is cut at the end
+ * of the file and rounded up to whole sectors.  Takes no lock other than
+ * the buffer cache's, so it is safe during eviction. */
+void
+inode_write_page (struct inode *inode, off_t ofs, const void *kva,
+		size_t size) {
+	const uint8_t *page = kva;
+	off_t length = inode_length (inode) - ofs;
+	off_t pos;
+
+	ASSERT (ofs % PGSIZE == 0);
+	ASSERT (size <= PGSIZE);
+
+	if (length < (off_t) size)
+		size = length > 0 ? length : 0;
+	for (pos = 0; pos < (off_t) size; pos += DISK_SECTOR_SIZE)
+		cache_write_direct (byte_to_sector (inode, ofs + pos), page + pos);
+}
+
 /* Disables writes to INODE.
    May be called at most once per inode opener. */
 	void
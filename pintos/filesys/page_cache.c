@@ -1,9 +1,47 @@
-/* page_cache.c: Implementation of Page Cache (Buffer Cache). */
+/* page_cache.c: Implementation of Page Cache (Buffer Cache).
+ *
+ * With VM, the contents of files live in VM_PAGE_CACHE pages instead of
+ * the sector buffer cache, which is left with inodes and the FAT.  The
+ * pages belong to the address space of the page cache worker thread,
+ * each mapped at an address of its own, so the frame table treats them
+ * like user pages: the same clock evicts them, their accessed and dirty
+ * bits live in the worker's page table, and swapping one out writes it
+ * back to its file.  Page cache frames are published in the page index,
+ * so mmap pages and executable pages of the same file map them instead
+ * of reading copies of their own.
+ *
+ * The worker reads pages ahead of sequential readers, as
+ * inode_readahead() asks, and writes dirty pages back every
+ * PC_FLUSH_TICKS timer ticks.
+ *
+ * PC_LOCK protects the page map, the page list, the address slots, each
+ * page's BUSY flag and the read-ahead queue.  Locks are taken in the
+ * order filesys_lock, PC_LOCK, frame_lock.  PC_LOCK is never taken on the
+ * eviction path, which only calls page_cache_writeback(), and pages are
+ * unlinked from their frames without it, since that may wait for an
+ * evictor's write-back.  Data is copied to and from callers' buffers with
+ * the frame pinned and no lock held, since a buffer may be user memory
+ * and fault. */
 
 #include "vm/vm.h"
+#if defined (VM) && defined (EFILESYS)
+#include <bitmap.h>
+#include <debug.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
 static bool page_cache_readahead (struct page *page, void *kva);
 static bool page_cache_writeback (struct page *page);
 static void page_cache_destroy (struct page *page);
+static void page_cache_kworkerd (void *aux);
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations page_cache_op = {
@@ -13,38 +51,501 @@ static const struct page_operations page_cache_op = {
 	.type = VM_PAGE_CACHE,
 };
 
+/* Address of the first page in the worker's address space. */
+#define PC_BASE ((uint8_t *) 0x10000000)
+/* Ticks a written page may stay dirty before write-behind. */
+#define PC_FLUSH_TICKS TIMER_FREQ
+/* Ticks the worker naps while dirty pages wait for write-behind. */
+#define PC_POLL_TICKS (TIMER_FREQ / 25)
+/* Read-ahead requests that may be queued at once. */
+#define PC_QUEUE 16
+
+/* A queued read-ahead. */
+struct readahead {
+	struct inode *inode;                /* Reopened for the request. */
+	off_t ofs;                          /* Page to read. */
+};
+
 tid_t page_cache_workerd;
+static struct thread *pc_thread;        /* Worker, owner of every page. */
+static struct semaphore pc_started;     /* Worker has its page table. */
+static struct semaphore pc_work;        /* Read-ahead queued or data
+                                           dirtied. */
+
+static struct hash pc_map;              /* Pages by inode and offset. */
+static struct list pc_pages;            /* All pages. */
+static struct bitmap *pc_slots;         /* Addresses in use. */
+static struct lock pc_lock;
+static struct condition pc_ready;       /* A busy page was read in. */
+
+static struct readahead pc_queue[PC_QUEUE];
+static size_t pc_queue_head;
+static size_t pc_queue_cnt;
+
+static bool pc_dirty;                   /* Written since the last pass. */
+static int64_t pc_dirty_since;          /* When PC_DIRTY was set. */
+
+/* Statistics. */
+static unsigned long long pc_hits;
+static unsigned long long pc_misses;
+static unsigned long long pc_readaheads;
+static unsigned long long pc_readahead_hits;
+static unsigned long long pc_disk_reads;
+static unsigned long long pc_writebacks;
+
+static hash_hash_func page_cache_hash;
+static hash_less_func page_cache_less;
 
 /* The initializer of file vm */
 void
 pagecache_init (void) {
-	/* TODO: Create a worker daemon for page cache with page_cache_kworkerd */
+	/* No file has more pages than sectors, so a slot per sector of the
+	   disk is enough for every page that can exist at once. */
+	pc_slots = bitmap_create (disk_size (filesys_disk));
+	if (pc_slots == NULL
+			|| !hash_init (&pc_map, page_cache_hash, page_cache_less, NULL))
+		PANIC ("page cache allocation failed");
+	list_init (&pc_pages);
+	lock_init (&pc_lock);
+	cond_init (&pc_ready);
+	sema_init (&pc_started, 0);
+	sema_init (&pc_work, 0);
+
+	page_cache_workerd = thread_create ("kworkerd", PRI_DEFAULT,
+			page_cache_kworkerd, NULL);
+	if (page_cache_workerd == TID_ERROR)
+		PANIC ("failed to start page cache worker");
+	sema_down (&pc_started);
 }
 
 /* Initialize the page cache */
 bool
-page_cache_initializer (struct page *page, enum vm_type type, void *kva) {
+page_cache_initializer (struct page *page, enum vm_type type UNUSED,
+		void *kva UNUSED) {
 	/* Set up the handler */
 	page->operations = &page_cache_op;
+	return true;
+}
+
+static uint64_t
+page_cache_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct page *p = hash_entry (e, struct page, page_cache.elem);
+	return hash_bytes (&p->page_cache.inode, sizeof p->page_cache.inode)
+		^ hash_int (p->page_cache.ofs / PGSIZE);
+}
+
+static bool
+page_cache_less (const struct hash_elem *a_, const struct hash_elem *b_,
+		void *aux UNUSED) {
+	const struct page *a = hash_entry (a_, struct page, page_cache.elem);
+	const struct page *b = hash_entry (b_, struct page, page_cache.elem);
+	if (a->page_cache.inode != b->page_cache.inode)
+		return a->page_cache.inode < b->page_cache.inode;
+	return a->page_cache.ofs < b->page_cache.ofs;
+}
+
+/* Returns the page caching INODE at OFS, or a null pointer.
+ * PC_LOCK must be held. */
+static struct page *
+page_cache_lookup (struct inode *inode, off_t ofs) {
+	struct page key;
+	struct hash_elem *e;
+
+	key.page_cache.inode = inode;
+	key.page_cache.ofs = ofs;
+	e = hash_find (&pc_map, &key.page_cache.elem);
+	return e != NULL ? hash_entry (e, struct page, page_cache.elem) : NULL;
+}
+
+/* Creates the non-resident page caching INODE at OFS.  Returns a null
+ * pointer if memory is short.  PC_LOCK must be held. */
+static struct page *
+page_cache_create (struct inode *inode, off_t ofs) {
+	size_t slot = bitmap_scan_and_flip (pc_slots, 0, 1, false);
+	struct page *page;
+
+	if (slot == BITMAP_ERROR)
+		return NULL;
+	page = malloc (sizeof *page);
+	if (page == NULL) {
+		bitmap_reset (pc_slots, slot);
+		return NULL;
+	}
+
+	*page = (struct page) {
+		.va = PC_BASE + slot * PGSIZE,
+		.writable = true,
+		.owner = pc_thread,
+	};
+	page_cache_initializer (page, VM_PAGE_CACHE, NULL);
+	page->page_cache.inode = inode;
+	page->page_cache.ofs = ofs;
+	page->page_cache.busy = false;
+	page->page_cache.readahead = false;
+	hash_insert (&pc_map, &page->page_cache.elem);
+	list_push_back (&pc_pages, &page->page_cache.list_elem);
+	return page;
+}
+
+/* Returns the page caching the page of INODE at OFS, resident and with
+ * its frame pinned, reading it from disk on a miss.  A SPECULATIVE read
+ * only takes a spare frame and never evicts.  Returns a null pointer if
+ * there is no memory for the page. */
+static struct page *
+page_cache_get (struct inode *inode, off_t ofs, bool speculative) {
+	struct page *page;
+	bool missed = false;
+
+	lock_acquire (&pc_lock);
+	for (;;) {
+		bool loaded;
+
+		page = page_cache_lookup (inode, ofs);
+		if (page == NULL && (page = page_cache_create (inode, ofs)) == NULL)
+			break;
+		if (page->page_cache.busy) {
+			cond_wait (&pc_ready, &pc_lock);
+			continue;
+		}
+		if (vm_frame_pin (page) != NULL) {
+			if (!speculative && !missed) {
+				pc_hits++;
+				if (page->page_cache.readahead)
+					pc_readahead_hits++;
+				page->page_cache.readahead = false;
+			}
+			break;
+		}
+
+		/* Read it in without PC_LOCK, since that may evict.  It may be
+		   evicted again before it is pinned, and then is read again. */
+		page->page_cache.busy = true;
+		lock_release (&pc_lock);
+		loaded = vm_claim_cache_page (page, speculative);
+		lock_acquire (&pc_lock);
+		page->page_cache.busy = false;
+		cond_broadcast (&pc_ready, &pc_lock);
+		if (!loaded) {
+			page = NULL;
+			break;
+		}
+		page->page_cache.readahead = speculative;
+		if (!speculative && !missed) {
+			pc_misses++;
+			missed = true;
+		}
+	}
+	lock_release (&pc_lock);
+
+	if (page != NULL)
+		pml4_set_accessed (pc_thread->pml4, page->va, true);
+	return page;
+}
+
+/* Asks the worker to read the page of INODE at OFS, unless it is past
+ * the end of the file, already resident or already queued.  The request
+ * is dropped if the queue is full. */
+void
+page_cache_prefetch (struct inode *inode, off_t ofs) {
+	struct page *page;
+	bool wake = false;
+	size_t i;
+
+	if (ofs >= inode_length (inode))
+		return;
+
+	lock_acquire (&pc_lock);
+	page = page_cache_lookup (inode, ofs);
+	if ((page == NULL || page->frame == NULL) && pc_queue_cnt < PC_QUEUE) {
+		wake = true;
+		for (i = 0; i < pc_queue_cnt; i++) {
+			struct readahead *ra = &pc_queue[(pc_queue_head + i) % PC_QUEUE];
+			if (ra->inode == inode && ra->ofs == ofs)
+				wake = false;
+		}
+		if (wake) {
+			struct readahead *ra =
+				&pc_queue[(pc_queue_head + pc_queue_cnt++) % PC_QUEUE];
+			ra->inode = inode_reopen (inode);
+			ra->ofs = ofs;
+		}
+	}
+	lock_release (&pc_lock);
+
+	if (wake)
+		sema_up (&pc_work);
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET,
+ * through the page cache.  Returns the number of bytes actually read, which may be less
+ * than SIZE if memory is short or end of file is reached. */
+off_t
+page_cache_read (struct inode *inode, void *buffer_, off_t size,
+		off_t offset) {
+	uint8_t *buffer = buffer_;
+	off_t bytes_read = 0;
+
+	while (size > 0) {
+		/* Starting byte offset within the page. */
+		int page_ofs = offset % PGSIZE;
+
+		/* Bytes left in inode, bytes left in page, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int page_left = PGSIZE - page_ofs;
+		int min_left = inode_left < page_left ? inode_left : page_left;
+
+		/* Number of bytes to actually copy out of this page. */
+		int chunk_size = size < min_left ? size : min_left;
+		struct page *page;
+
+		if (chunk_size <= 0)
+			break;
+		page = page_cache_get (inode, offset - page_ofs, false);
+		if (page == NULL)
+			break;
+		memcpy (buffer + bytes_read, page->frame->kva + page_ofs, chunk_size);
+		vm_frame_unpin (page->frame);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_read += chunk_size;
+	}
 
+	return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET, through
+ * the page cache.  The file is updated by write-behind, eviction or the
+ * last close.  Returns the number of bytes actually written, which may
+ * be less than SIZE if memory is short or end of file is reached. */
+off_t
+page_cache_write (struct inode *inode, const void *buffer_, off_t size,
+		off_t offset) {
+	const uint8_t *buffer = buffer_;
+	off_t bytes_written = 0;
+	bool wake = false;
+
+	while (size > 0) {
+		/* Starting byte offset within the page. */
+		int page_ofs = offset % PGSIZE;
+
+		/* Bytes left in inode, bytes left in page, lesser of the two. */
+		off_t inode_left = inode_length (inode) - offset;
+		int page_left = PGSIZE - page_ofs;
+		int min_left = inode_left < page_left ? inode_left : page_left;
+
+		/* Number of bytes to actually write into this page. */
+		int chunk_size = size < min_left ? size : min_left;
+		struct page *page;
+
+		if (chunk_size <= 0)
+			break;
+		page = page_cache_get (inode, offset - page_ofs, false);
+		if (page == NULL)
+			break;
+		memcpy (page->frame->kva + page_ofs, buffer + bytes_written,
+				chunk_size);
+		pml4_set_dirty (pc_thread->pml4, page->va, true);
+		vm_frame_unpin (page->frame);
+
+		/* Advance. */
+		size -= chunk_size;
+		offset += chunk_size;
+		bytes_written += chunk_size;
+	}
+
+	if (bytes_written > 0) {
+		lock_acquire (&pc_lock);
+		if (!pc_dirty) {
+			pc_dirty = true;
+			pc_dirty_since = timer_ticks ();
+			wake = true;
+		}
+		lock_release (&pc_lock);
+	}
+	if (wake)
+		sema_up (&pc_work);
+	return bytes_written;
+}
+
+/* Makes the page of INODE at OFS resident and returns its frame, pinned
+ * until the caller passes it to vm_frame_unpin(), so that a user page of
+ * the same file can map it.  Returns a null pointer if OFS is past the
+ * end of the file or memory is short. */
+struct frame *
+page_cache_hold (struct inode *inode, off_t ofs) {
+	struct page *page;
+
+	if (ofs >= inode_length (inode))
+		return NULL;
+	page = page_cache_get (inode, ofs, false);
+	return page != NULL ? page->frame : NULL;
+}
+
+/* Drops every page of INODE, which is being closed for the last time.
+ * Dirty pages are written back first unless DISCARD, as for a removed
+ * file.  No user page maps them any more, since mappings keep the file
+ * open. */
+void
+page_cache_drop (struct inode *inode, bool discard) {
+	struct list dropped;
+	struct list_elem *e;
+
+	/* Take the pages out of sight first, so that they can be written
+	   back and freed without PC_LOCK. */
+	list_init (&dropped);
+	lock_acquire (&pc_lock);
+	for (e = list_begin (&pc_pages); e != list_end (&pc_pages);) {
+		struct page *page = list_entry (e, struct page, page_cache.list_elem);
+
+		if (page->page_cache.inode != inode) {
+			e = list_next (e);
+			continue;
+		}
+		ASSERT (!page->page_cache.busy);
+		e = list_remove (e);
+		hash_delete (&pc_map, &page->page_cache.elem);
+		list_push_back (&dropped, &page->page_cache.list_elem);
+	}
+	lock_release (&pc_lock);
+
+	while (!list_empty (&dropped)) {
+		struct page *page = list_entry (list_pop_front (&dropped),
+				struct page, page_cache.list_elem);
+
+		/* The pin keeps the frame from eviction until the page is
+		   unlinked from it in page_cache_destroy(). */
+		if (vm_frame_pin (page) != NULL && !discard)
+			page_cache_writeback (page);
+		vm_dealloc_page (page);
+	}
+}
+
+/* Writes every dirty page back to its file. */
+void
+page_cache_flush (void) {
+	struct list_elem *e;
+
+	lock_acquire (&pc_lock);
+	pc_dirty = false;
+	for (e = list_begin (&pc_pages); e != list_end (&pc_pages);
+			e = list_next (e)) {
+		struct page *page = list_entry (e, struct page, page_cache.list_elem);
+
+		if (!page->page_cache.busy && vm_frame_pin (page) != NULL) {
+			page_cache_writeback (page);
+			vm_frame_unpin (page->frame);
+		}
+	}
+	lock_release (&pc_lock);
 }
 
 /* Utilze the Swap in mechanism to implement readhead */
 static bool
 page_cache_readahead (struct page *page, void *kva) {
+	inode_read_page (page->page_cache.inode, page->page_cache.ofs, kva);
+	pc_disk_reads++;
+	return true;
 }
 
 /* Utilze the Swap out mechanism to implement writeback */
 static bool
 page_cache_writeback (struct page *page) {
+	struct page_cache *page_cache = &page->page_cache;
+
+	if (!pml4_is_dirty (page->owner->pml4, page->va))
+		return true;
+
+	/* Cleared first, so a write racing with the I/O leaves it dirty. */
+	pml4_set_dirty (page->owner->pml4, page->va, false);
+	inode_write_page (page_cache->inode, page_cache->ofs, page->frame->kva,
+			PGSIZE);
+	pc_writebacks++;
+	return true;
 }
 
 /* Destory the page_cache. */
 static void
 page_cache_destroy (struct page *page) {
+	if (page->frame != NULL) {
+		pml4_clear_page (page->owner->pml4, page->va);
+		vm_frame_unlink (page);
+	}
+	lock_acquire (&pc_lock);
+	bitmap_reset (pc_slots, ((uint8_t *) page->va - PC_BASE) / PGSIZE);
+	lock_release (&pc_lock);
+}
+
+/* Serves the queued read-aheads. */
+static void
+page_cache_run_queue (void) {
+	lock_acquire (&pc_lock);
+	while (pc_queue_cnt > 0) {
+		struct readahead ra = pc_queue[pc_queue_head];
+		struct page *page;
+
+		pc_queue_head = (pc_queue_head + 1) % PC_QUEUE;
+		pc_queue_cnt--;
+		lock_release (&pc_lock);
+
+		page = page_cache_get (ra.inode, ra.ofs, true);
+		if (page != NULL) {
+			vm_frame_unpin (page->frame);
+			pc_readaheads++;
+		}
+		/* The last close drops the file's pages, which takes PC_LOCK
+		   again after filesys_lock. */
+		lock_acquire (&filesys_lock);
+		inode_close (ra.inode);
+		lock_release (&filesys_lock);
+
+		lock_acquire (&pc_lock);
+	}
+	lock_release (&pc_lock);
 }
 
 /* Worker thread for page cache */
 static void
-page_cache_kworkerd (void *aux) {
+page_cache_kworkerd (void *aux UNUSED) {
+	struct thread *t = thread_current ();
+
+	/* The pages are mapped here, at addresses nobody else uses. */
+	t->pml4 = pml4_create ();
+	if (t->pml4 == NULL)
+		PANIC ("page cache worker: no page table");
+	pc_thread = t;
+	sema_up (&pc_started);
+
+	for (;;) {
+		/* Sleep until there is work, but keep an eye on the clock while
+		   dirty data waits for write-behind. */
+		if (pc_dirty)
+			timer_sleep (PC_POLL_TICKS);
+		else
+			sema_down (&pc_work);
+
+		page_cache_run_queue ();
+		if (pc_dirty && timer_elapsed (pc_dirty_since) >= PC_FLUSH_TICKS)
+			page_cache_flush ();
+	}
+}
+
+/* Adds the page cache's hits, misses and hits on pages read ahead so
+ * far to *HITS, *MISSES and *RA_HITS.  Read-ahead itself is not
+ * counted. */
+void
+page_cache_get_stats (uint64_t *hits, uint64_t *misses, uint64_t *ra_hits) {
+	*hits += pc_hits;
+	*misses += pc_misses;
+	*ra_hits += pc_readahead_hits;
+}
+
+/* Prints page cache statistics. */
+void
+page_cache_print_stats (void) {
+	printf ("Page cache: %llu hits, %llu misses, %llu read ahead, "
+			"%llu disk reads, %llu writebacks\n",
+			pc_hits, pc_misses, pc_readaheads, pc_disk_reads, pc_writebacks);
 }
+#endif /* VM && EFILESYS */
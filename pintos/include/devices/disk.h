@@ -2,6 +2,7 @@
 #define DEVICES_DISK_H
 
 #include <inttypes.h>
+#include <stddef.h>
 #include <stdint.h>
 
 /* Size of a disk sector in bytes. */
@@ -15,6 +16,15 @@ typedef uint32_t disk_sector_t;
  * printf ("sector=%"PRDSNu"\n", sector); */
 #define PRDSNu PRIu32
 
+/* Maximum number of sectors moved by a single disk command. */
+#define DISK_XFER_MAX 256
+
+/* One buffer of a multi-sector transfer: CNT sectors at BUFFER. */
+struct disk_seg {
+	void *buffer;
+	size_t cnt;
+};
+
 void disk_init (void);
 void disk_print_stats (void);
 
@@ -22,6 +32,10 @@ struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
 void disk_write (struct disk *, disk_sector_t, const void *);
+void disk_readv (struct disk *, disk_sector_t,
+		const struct disk_seg *, size_t seg_cnt);
+void disk_writev (struct disk *, disk_sector_t,
+		const struct disk_seg *, size_t seg_cnt);
 
 void 	register_disk_inspect_intr ();
 #endif /* devices/disk.h */
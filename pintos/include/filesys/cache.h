@@ -0,0 +1,24 @@
+#ifndef FILESYS_CACHE_H
+#define FILESYS_CACHE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "devices/disk.h"
+#include "filesys/off_t.h"
+
+/* Number of sectors in the buffer cache. */
+#define CACHE_SIZE_DEFAULT 64
+extern size_t cache_size;
+
+void cache_init (void);
+void cache_read (disk_sector_t, void *, off_t ofs, size_t size);
+void cache_write (disk_sector_t, const void *, off_t ofs, size_t size);
+void cache_read_direct (disk_sector_t, void *);
+void cache_write_direct (disk_sector_t, const void *);
+void cache_readahead (disk_sector_t);
+void cache_flush (void);
+void cache_done (void);
+void cache_get_stats (uint64_t *hits, uint64_t *misses, uint64_t *ra_hits);
+void cache_print_stats (void);
+
+#endif /* filesys/cache.h */
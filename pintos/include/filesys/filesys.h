@@ -10,7 +10,13 @@ extern struct lock filesys_lock;
 
 /* Sectors of system file inodes. */
 #define FREE_MAP_SECTOR 0 /* Free map file inode sector. */
+#ifdef EFILESYS
+#include "filesys/fat.h"
+/* Root directory file inode sector: the first data cluster. */
+#define ROOT_DIR_SECTOR cluster_to_sector(ROOT_DIR_CLUSTER)
+#else
 #define ROOT_DIR_SECTOR 1 /* Root directory file inode sector. */
+#endif
 
 /* Disk used for file system. */
 extern struct disk *filesys_disk;
@@ -8,6 +8,8 @@
 struct bitmap;
 
 void inode_init (void);
+bool inode_sector_allocate (disk_sector_t *);
+void inode_sector_release (disk_sector_t);
 bool inode_create (disk_sector_t, off_t);
 struct inode *inode_open (disk_sector_t);
 struct inode *inode_reopen (struct inode *);
@@ -15,7 +17,10 @@ disk_sector_t inode_get_inumber (const struct inode *);
 void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
+void inode_readahead (struct inode *, off_t offset, off_t size);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+void inode_read_page (struct inode *, off_t ofs, void *);
+void inode_write_page (struct inode *, off_t ofs, const void *, size_t size);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
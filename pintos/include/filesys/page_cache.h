@@ -1,12 +1,34 @@
 #ifndef FILESYS_PAGE_CACHE_H
 #define FILESYS_PAGE_CACHE_H
-#include "vm/vm.h"
+#include <hash.h>
+#include <stdint.h>
+#include <list.h>
+#include "filesys/off_t.h"
 
 struct page;
 enum vm_type;
+struct inode;
+struct frame;
 
-struct page_cache {};
+struct page_cache {
+	struct inode *inode;        /* File the page caches. */
+	off_t ofs;                  /* Offset in INODE, page-aligned. */
+	bool busy;                  /* Being read in. */
+	bool readahead;             /* Read ahead, not yet used. */
+	struct hash_elem elem;      /* Element in the page map. */
+	struct list_elem list_elem; /* Element in the page list. */
+};
 
-void page_cache_init (void);
+void pagecache_init (void);
 bool page_cache_initializer (struct page *page, enum vm_type type, void *kva);
+off_t page_cache_read (struct inode *, void *, off_t size, off_t offset);
+off_t page_cache_write (struct inode *, const void *, off_t size,
+		off_t offset);
+void page_cache_prefetch (struct inode *, off_t ofs);
+struct frame *page_cache_hold (struct inode *, off_t ofs);
+void page_cache_drop (struct inode *, bool discard);
+void page_cache_flush (void);
+void page_cache_get_stats (uint64_t *hits, uint64_t *misses,
+		uint64_t *ra_hits);
+void page_cache_print_stats (void);
 #endif
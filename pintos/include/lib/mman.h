@@ -0,0 +1,9 @@
+#ifndef __LIB_MMAN_H
+#define __LIB_MMAN_H
+
+/* Flags for msync().  Exactly one of MS_ASYNC and MS_SYNC must be
+   given. */
+#define MS_ASYNC 1              /* Schedule the write-back and return. */
+#define MS_SYNC 4               /* Write back before returning. */
+
+#endif /* lib/mman.h */
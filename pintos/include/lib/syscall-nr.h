@@ -36,6 +36,11 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Extra for Project 3 */
+	SYS_VMSTAT,                 /* Read virtual memory statistics. */
+	SYS_MSYNC,                  /* Write back a mapped range. */
+	SYS_SETRSS,                 /* Limit the resident set size. */
 };
 
 #endif /* lib/syscall-nr.h */
@@ -4,6 +4,8 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <mman.h>
+#include <vmstat.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -41,6 +43,9 @@ int dup2(int oldfd, int newfd);
 /* Project 3 and optionally project 4. */
 void *mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 void munmap (void *addr);
+bool vmstat (int scope, struct vmstat *st);
+int msync (void *addr, size_t length, int flags);
+void setrss (size_t pages);
 
 /* Project 4 only. */
 bool chdir (const char *dir);
@@ -0,0 +1,55 @@
+#ifndef __LIB_VMSTAT_H
+#define __LIB_VMSTAT_H
+
+#include <stdint.h>
+
+/* Number of buckets in the fault latency histogram.  Bucket I
+   counts faults that took [2^I, 2^(I+1)) TSC cycles; the last
+   bucket also counts everything slower. */
+#define VMSTAT_HIST_BUCKETS 32
+
+/* Scopes accepted by vmstat(). */
+#define VMSTAT_PROCESS 0        /* The calling process. */
+#define VMSTAT_GLOBAL 1         /* The whole system since boot. */
+
+/* Virtual memory statistics, as returned by vmstat(). */
+struct vmstat {
+	/* Page faults, by how they were resolved. */
+	uint64_t minor_faults;      /* Resolved without I/O, e.g. zero fill. */
+	uint64_t stack_faults;      /* Stack growth. */
+	uint64_t elf_faults;        /* First touch of a lazy executable page. */
+	uint64_t mmap_faults;       /* Page read from a mapped file. */
+	uint64_t swapin_faults;     /* Anonymous page read back from swap. */
+	uint64_t wp_faults;         /* Write to a copy-on-write page. */
+
+	/* Evictions of the process's pages. */
+	uint64_t clean_evictions;   /* Dropped without a write. */
+	uint64_t dirty_evictions;   /* Written back first. */
+
+	/* Faults of the calling process since its last exec(), and pages
+	   it got mapped by exec() ahead of their first access.  Not kept
+	   for VMSTAT_GLOBAL. */
+	uint64_t exec_faults;
+	uint64_t prefaulted;
+
+	/* Resident set, in pages.  For VMSTAT_GLOBAL, the frames in use
+	   and the size of the user pool. */
+	uint64_t rss;
+	uint64_t rss_limit;         /* Set by setrss(), 0 if unlimited. */
+
+	/* Work of the whole system.  Only kept for VMSTAT_GLOBAL. */
+	uint64_t writebacks;        /* Pages written back to swap or to their
+	                               files, by evictions, the page-out
+	                               daemon and msync(). */
+	uint64_t pageout_evictions; /* Frames freed by the page-out daemon. */
+	uint64_t ksm_merged;        /* Frames freed by same-page merging. */
+	uint64_t cache_hits;        /* File system accesses served by the
+	                               buffer cache or the page cache. */
+	uint64_t cache_misses;      /* Those that had to read the disk. */
+	uint64_t readahead_hits;    /* Hits on data that was read ahead. */
+
+	/* Latency of the faults above, log2-bucketed in TSC cycles. */
+	uint64_t latency[VMSTAT_HIST_BUCKETS];
+};
+
+#endif /* lib/vmstat.h */
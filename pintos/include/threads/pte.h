@@ -41,5 +41,12 @@
 #define PTE_U 0x4                        /* 1=user/kernel, 0=kernel only. */
 #define PTE_A 0x20                       /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40                       /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80                      /* 1=PDE maps a 2 MiB page. */
+
+/* A page directory entry with PTE_PS set maps a whole 2 MiB huge page
+   instead of pointing to a page table. */
+#define HUGE_PGSIZE (1UL << PDXSHIFT)    /* Bytes in a huge page. */
+#define HUGE_PGMASK (HUGE_PGSIZE - 1)    /* Offset bits in a huge page. */
+#define is_huge_pte(pte) ((*(pte) & (PTE_P | PTE_PS)) == (PTE_P | PTE_PS))
 
 #endif /* threads/pte.h */
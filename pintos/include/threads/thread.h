@@ -130,6 +130,10 @@ struct thread {
   struct supplemental_page_table spt;
   void *user_rsp;  // 사용자 -> 커널 전환 시 유저 스택 포인터를 저장할 멤버 변수
   struct list mmaps;  // 이 스레드의 mmap region 리스트
+  struct vmstat vmstat;  // 이 프로세스의 fault/eviction 통계
+  size_t vm_committed;   // 이 프로세스가 예약한 anon 페이지 수
+  size_t rss;            // frame에 올라와 있는 페이지 수 (frame_lock)
+  size_t rss_limit;      // rss 상한, 0이면 제한 없음
 #endif
 
   /* Owned by thread.c. */
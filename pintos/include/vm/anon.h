@@ -10,5 +10,14 @@ struct anon_page {
 
 void vm_anon_init(void);
 bool anon_initializer(struct page *page, enum vm_type type, void *kva);
+size_t anon_swap_slots(void);
+bool anon_has_swap_copy(struct page *page);
+bool anon_writeback(struct page *page);
+bool anon_writeback_cluster(struct page **pages, size_t cnt);
+void anon_swap_share(struct page *dst, struct page *src);
+void anon_swap_unshare(struct page *page);
+void anon_fork(struct page *child, struct page *parent);
+size_t anon_reclaim_swap_cache(void);
+void anon_print_stats(void);
 
 #endif
@@ -6,6 +6,7 @@
 #include "vm/vm.h"
 
 struct page;
+struct thread;
 enum vm_type;
 
 struct file_page {
@@ -15,16 +16,26 @@ struct file_page {
   size_t zero_bytes;  // 나머지 0으로 채울 바이트 수
 };
 
-struct mmap_region {
-  void *base;     // 매핑 시작 주소 (page-aligned)
-  size_t npages;  // 매핑된 총 페이지 수
-  struct file *file;
-  struct list_elem elem;
+/* A virtual memory area: one mmap()ed range of the address space.
+ * Pages are created from it on first access. */
+struct vma {
+  void *base;         // 매핑 시작 주소 (page-aligned)
+  size_t length;      // 매핑 길이 (PGSIZE의 배수)
+  struct file *file;  // 이 매핑 전용으로 다시 연 파일
+  off_t ofs;          // base에 대응하는 파일 오프셋
+  size_t read_bytes;  // 파일에서 읽는 바이트 수, 나머지는 0
+  bool writable;
+  struct list_elem elem;  // thread의 mmaps 리스트 entry
 };
 
 void vm_file_init(void);
 bool file_backed_initializer(struct page *page, enum vm_type type, void *kva);
+bool file_backed_writeback(struct page *page);
 void *do_mmap(void *addr, size_t length, int writable, struct file *file,
               off_t offset);
 void do_munmap(void *va);
+int do_msync(void *addr, size_t length, int flags);
+struct vma *vma_find(struct thread *t, void *va);
+struct page *vma_materialize(struct vma *vma, void *va);
+bool vma_fork(struct thread *parent);
 #endif
@@ -1,6 +1,7 @@
 #ifndef VM_VM_H
 #define VM_VM_H
 #include <stdbool.h>
+#include <vmstat.h>
 
 #include "threads/palloc.h"
 
@@ -50,11 +51,11 @@ struct page {
   struct frame *frame; /* Back reference for frame */
 
   /* Your implementation */
-  struct hash_elem hash_elem;  // SPT의 entry
   bool writable;               // true : write & read, false : read-only
 
   // page 소유 스레드 표기
   struct thread *owner;
+  struct list_elem frame_elem;  // frame->pages의 entry
 
   /* Per-type data are binded into the union.
    * Each function automatically detects the current union */
@@ -68,12 +69,55 @@ struct page {
   };
 };
 
-/* The representation of "frame" */
+/* The representation of "frame".
+ * Every page of the user pool has exactly one of these in the frame table.
+ * A frame is mapped by more than one page while it is shared
+ * copy-on-write after fork(), or when it holds file contents that several
+ * processes map (see the page index in vm.c). */
 struct frame {
   void *kva;
-  struct page *page;
+  struct list pages;  // 이 frame을 매핑한 page들
+  unsigned pin_cnt;   // 0이 아니면 swap in/설치/복사 중이라 eviction 제외
+  bool hot;     // CLOCK-Pro: working set에 속한 frame
+  bool test;    // CLOCK-Pro: cold frame의 테스트 기간 여부
+  bool flush;   // msync(MS_ASYNC)로 page-out daemon의 write back 대기 중
+  bool io;      // evictor가 frame_lock 없이 write back 중. pages 목록 고정
+  uint64_t ksm_sum;  // KSM: 지난 검사 때의 checksum (0이면 아직 없음)
+
+  /* Page index: file contents this frame holds, if it is published. */
+  struct inode *inode;    // NULL이면 index에 없음
+  off_t ofs;              // inode 안의 오프셋 (PGSIZE 정렬)
+  size_t read_bytes;      // 파일에서 읽은 바이트 수, 나머지는 0
+  struct hash_elem index_elem;
 };
 
+/* Page replacement policies for vm_get_victim(). */
+enum vm_replace_policy {
+  VM_RP_CLOCK,     /* Single-hand second-chance clock. */
+  VM_RP_CLOCK_PRO, /* Hot/cold/test clock with scan resistance. */
+};
+extern enum vm_replace_policy vm_replace_policy;
+
+/* How exec() maps the pages of an executable. */
+enum vm_load_policy {
+  VM_LOAD_LAZY,   /* Every page on its first fault. */
+  VM_LOAD_EAGER,  /* Every page with file contents at exec time. */
+  VM_LOAD_HYBRID, /* Text, and the first VM_PREFAULT_DATA data pages. */
+};
+extern enum vm_load_policy vm_load_policy;
+#define VM_PREFAULT_DATA 4
+
+/* Free-frame watermarks of the page-out daemon, in pages. */
+extern size_t vm_low_watermark;
+extern size_t vm_high_watermark;
+
+/* Fault-around window of file-backed lazy pages, in pages. */
+#define VM_FAULT_AROUND_MAX 64
+extern size_t vm_fault_around;
+
+/* Frames the same-page merging scanner visits per pass; 0 disables it. */
+extern size_t vm_ksm_pages;
+
 /* The function table for page operations.
  * This is one way of implementing "interface" in C.
  * Put the table of "method" into the struct's member, and
@@ -91,10 +135,10 @@ struct page_operations {
   if ((page)->operations->destroy) (page)->operations->destroy(page)
 
 /* Representation of current process's memory space.
- * We don't want to force you to obey any specific design for this struct.
- * All designs up to you for this. */
+ * A radix tree keyed by virtual page number, shaped like the pml4.
+ * See vm.c for details. */
 struct supplemental_page_table {
-  struct hash page_map;
+  void *root;  // 최상위 노드, 페이지가 하나도 없으면 NULL
 };
 
 /* per-page context for lazy_load_segment() */
@@ -112,10 +156,17 @@ bool supplemental_page_table_copy(struct supplemental_page_table *dst,
                                   struct supplemental_page_table *src);
 void supplemental_page_table_kill(struct supplemental_page_table *spt);
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va);
+struct page *spt_find_next(struct supplemental_page_table *spt, void *va);
 bool spt_insert_page(struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page);
 
 void vm_init(void);
+bool vm_set_replace_policy(const char *name);
+bool vm_set_load_policy(const char *name);
+void vm_prefault_segment(void *upage, size_t read_bytes, bool writable);
+void vm_set_fault_around(size_t pages);
+void vm_print_stats(void);
+void vm_get_stats(int scope, struct vmstat *st);
 bool vm_try_handle_fault(struct intr_frame *f, void *addr, bool user,
                          bool write, bool not_present);
 
@@ -125,7 +176,23 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
                                     bool writable, vm_initializer *init,
                                     void *aux);
 void vm_dealloc_page(struct page *page);
+struct frame *vm_kva_to_frame(void *kva);
+void vm_frame_unlink(struct page *page);
+bool vm_frame_share(struct page *src, struct page *dst);
+struct frame *vm_frame_pin(struct page *page);
+void vm_frame_unpin(struct frame *frame);
+struct frame *vm_get_spare_frame(void);
+size_t vm_reclaim_swap_cache(void);
+bool vm_sync_page(struct page *page, bool async);
+bool vm_claim_page_for_write(void *va);
+bool vm_pin_buffer(void *buffer, size_t size);
+void vm_unpin_buffer(void *buffer, size_t size);
+bool vm_map_frame(struct page *page, struct frame *frame);
+void vm_file_written(struct inode *inode, off_t ofs, off_t size);
+bool vm_commit_pages(struct thread *t, size_t cnt);
+void vm_uncommit_pages(struct thread *t, size_t cnt);
 bool vm_claim_page(void *va);
+bool vm_claim_cache_page(struct page *page, bool speculative);
 enum vm_type page_get_type(struct page *page);
 
 #endif /* VM_VM_H */
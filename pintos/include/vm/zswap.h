@@ -0,0 +1,16 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Size of the compressed swap pool, in pages; 0 disables it. */
+extern size_t zswap_pages;
+
+void zswap_init(size_t slot_cnt);
+bool zswap_store(size_t slot, const void *kva);
+bool zswap_load(size_t slot, void *kva);
+bool zswap_holds(size_t slot);
+void zswap_drop(size_t slot);
+void zswap_print_stats(void);
+
+#endif
@@ -112,6 +112,16 @@ void *mmap(void *addr, size_t length, int writable, int fd, off_t offset) {
 
 void munmap(void *addr) { syscall1(SYS_MUNMAP, addr); }
 
+bool vmstat(int scope, struct vmstat *st) {
+  return syscall2(SYS_VMSTAT, scope, st);
+}
+
+int msync(void *addr, size_t length, int flags) {
+  return syscall3(SYS_MSYNC, addr, length, flags);
+}
+
+void setrss(size_t pages) { syscall1(SYS_SETRSS, pages); }
+
 bool chdir(const char *dir) { return syscall1(SYS_CHDIR, dir); }
 
 bool mkdir(const char *dir) { return syscall1(SYS_MKDIR, dir); }
@@ -13,6 +13,7 @@ test_main (void) {
   int fd;
   char c;
   long long read_cnt, write_cnt;
+  struct vmstat before, after;
 
   CHECK (create (file_name, sizeof buf), "create \"%s\"", file_name);
   CHECK ((fd = open (file_name)) > 1, "open \"%s\"", file_name);
@@ -23,6 +24,7 @@ test_main (void) {
 
   CHECK (write (fd, buf, sizeof buf) > 0, "write \"%s\"", file_name);
 
+  CHECK (vmstat (VMSTAT_GLOBAL, &before), "vmstat");
   seek(fd, 0);
   for (int i = 0; i < TEST_SIZE; i++){
     read(fd, &c, 1);
@@ -38,6 +40,11 @@ test_main (void) {
     if (c != 'a') fail("file content mismatch in %d : %x %x", i, buf[i], c);
   }
 
+  CHECK (vmstat (VMSTAT_GLOBAL, &after), "vmstat after access");
+  CHECK (after.cache_hits - before.cache_hits >= 3 * TEST_SIZE,
+        "every access hit the cache");
+  CHECK (after.cache_misses == before.cache_misses, "no access missed");
+
   CHECK (get_fs_disk_read_cnt() <= read_cnt, 
         "check read_cnt");
   CHECK (get_fs_disk_write_cnt() <= write_cnt + TEST_SIZE / 512, 
@@ -7,6 +7,10 @@ check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
 (bc-easy) create "data"
 (bc-easy) open "data"
 (bc-easy) write "data"
+(bc-easy) vmstat
+(bc-easy) vmstat after access
+(bc-easy) every access hit the cache
+(bc-easy) no access missed
 (bc-easy) check read_cnt
 (bc-easy) check write_cnt
 (bc-easy) close "data"
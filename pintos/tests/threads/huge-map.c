@@ -0,0 +1,64 @@
+/* Checks that the kernel maps the user pool, which lies in the upper
+   part of physical memory, mostly with 2 MB pages, that memory read
+   and written through them lands at the right physical address, and
+   that the kernel text is still mapped read-only with 4 kB pages. */
+
+#include <stdint.h>
+#include "tests/threads/tests.h"
+#include "threads/init.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/pte.h"
+#include "threads/vaddr.h"
+
+#define PAGE_CNT 16
+
+void
+test_huge_map (void) 
+{
+  uint64_t *pte;
+  void *pages[PAGE_CNT];
+  int huge = 0;
+  int i;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      uint64_t *p = pages[i] = palloc_get_page (PAL_USER | PAL_ASSERT);
+      size_t j;
+
+      pte = pml4e_walk (base_pml4, (uint64_t) p, 0);
+      if (pte == NULL)
+        fail ("page %d is not mapped", i);
+      if (is_huge_pte (pte))
+        {
+          huge++;
+          if ((PTE_ADDR (*pte) & ~HUGE_PGMASK) + ((uint64_t) p & HUGE_PGMASK)
+              != vtop (p))
+            fail ("huge page of page %d maps the wrong address", i);
+          if (!(*pte & PTE_W))
+            fail ("huge page of page %d is read-only", i);
+        }
+      for (j = 0; j < PGSIZE / sizeof *p; j++)
+        p[j] = vtop (p) + j;
+    }
+  if (huge == 0)
+    fail ("no user pool page is in a huge page");
+  msg ("user pool is mapped with huge pages");
+
+  for (i = 0; i < PAGE_CNT; i++)
+    {
+      uint64_t *p = pages[i];
+      size_t j;
+
+      for (j = 0; j < PGSIZE / sizeof *p; j++)
+        if (p[j] != vtop (p) + j)
+          fail ("page %d holds bad data at word %zu", i, j);
+      palloc_free_page (p);
+    }
+  msg ("reads and writes through huge pages are correct");
+
+  pte = pml4e_walk (base_pml4, (uint64_t) test_huge_map, 0);
+  if (pte == NULL || is_huge_pte (pte) || (*pte & PTE_W))
+    fail ("kernel text is not mapped read-only with 4 kB pages");
+  msg ("kernel text is read-only");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(huge-map) begin
+(huge-map) user pool is mapped with huge pages
+(huge-map) reads and writes through huge pages are correct
+(huge-map) kernel text is read-only
+(huge-map) end
+EOF
+pass;
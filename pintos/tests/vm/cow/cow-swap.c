@@ -0,0 +1,52 @@
+/* Forks while most of the parent's memory is swapped out, so the child
+   shares swap slots as well as frames copy-on-write.  The child checks
+   and then overwrites every page; the parent must still see its own
+   data afterwards. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (8 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+static void
+check_pages (char xor)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunk[i * PAGE_SIZE] != (char) (i ^ xor))
+      fail ("data is inconsistent in page %zu", i);
+}
+
+void
+test_main (void)
+{
+  pid_t child;
+  size_t i;
+
+  msg ("write %d pages", PAGE_COUNT);
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunk[i * PAGE_SIZE] = i;
+
+  child = fork ("child");
+  if (child == 0) {
+    check_pages (0);
+    msg ("child: check data consistency");
+
+    for (i = 0; i < PAGE_COUNT; i++)
+      big_chunk[i * PAGE_SIZE] = i ^ 0x5a;
+    check_pages (0x5a);
+    msg ("child: check data change");
+    exit (0);
+  }
+
+  CHECK (wait (child) == 0, "wait for child");
+  check_pages (0);
+  msg ("parent: check data consistency");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(cow-swap) begin
+(cow-swap) write 2048 pages
+(cow-swap) child: check data consistency
+(cow-swap) child: check data change
+(cow-swap) wait for child
+(cow-swap) parent: check data consistency
+(cow-swap) end
+EOF
+pass;
@@ -0,0 +1,28 @@
+/* Runs with the eager load policy, under which exec() maps every page
+   of the executable that has file contents before the program starts.
+   Checks that vmstat() counts those pages as prefaulted and that none
+   of them had to be faulted in, even after touching all of this
+   program's code and data. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+/* Initialized data, so that it is read from the executable. */
+static int data[2048] = { 1 };
+
+void
+test_main (void)
+{
+  struct vmstat st;
+  size_t i;
+  int sum = 0;
+
+  for (i = 0; i < sizeof data / sizeof *data; i++)
+    sum += data[i];
+  CHECK (sum == 1, "initialized data reads correctly");
+
+  CHECK (vmstat (VMSTAT_PROCESS, &st), "vmstat");
+  CHECK (st.prefaulted > 0, "exec() prefaulted pages");
+  CHECK (st.elf_faults == 0, "no page of the executable was faulted in");
+}
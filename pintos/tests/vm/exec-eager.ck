@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(exec-eager) begin
+(exec-eager) initialized data reads correctly
+(exec-eager) vmstat
+(exec-eager) exec() prefaulted pages
+(exec-eager) no page of the executable was faulted in
+(exec-eager) end
+EOF
+pass;
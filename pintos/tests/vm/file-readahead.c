@@ -0,0 +1,28 @@
+/* Reads a large file from start to end in small blocks, as a program
+   streaming a file would, and checks that some of the reads were
+   served from data the kernel read ahead. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char block[512];
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  int handle, size, total = 0, n;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  size = filesize (handle);
+
+  CHECK (vmstat (VMSTAT_GLOBAL, &before), "vmstat");
+  while ((n = read (handle, block, sizeof block)) > 0)
+    total += n;
+  CHECK (vmstat (VMSTAT_GLOBAL, &after), "vmstat after reading");
+  CHECK (total == size, "read the whole file");
+  CHECK (after.readahead_hits > before.readahead_hits,
+         "reads hit data that was read ahead");
+  close (handle);
+}
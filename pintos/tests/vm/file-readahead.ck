@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(file-readahead) begin
+(file-readahead) open "large.txt"
+(file-readahead) vmstat
+(file-readahead) vmstat after reading
+(file-readahead) read the whole file
+(file-readahead) reads hit data that was read ahead
+(file-readahead) end
+EOF
+pass;
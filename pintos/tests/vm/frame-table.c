@@ -0,0 +1,59 @@
+/* Runs children one after another that each write more pages than the
+   6144 frames the frame table used to be limited to.  The frame table
+   has a frame for every page of the user pool, so on a machine with
+   enough memory nothing has to be evicted, and the frames of one child
+   go back to the pool when it exits, ready for the next one.  Swap is
+   only there so that the parent and a child can both be committed. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 6400
+#define RUNS 3
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+/* Writes every page of BUF and exits with 0 if none of them had to be
+   evicted. */
+static void
+touch_pages (void)
+{
+  struct vmstat st;
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    buf[i * PAGE_SIZE] = i;
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      exit (2);
+  if (!vmstat (VMSTAT_PROCESS, &st))
+    exit (3);
+  exit (st.clean_evictions + st.dirty_evictions == 0 ? 0 : 1);
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  int run;
+
+  CHECK (vmstat (VMSTAT_GLOBAL, &before), "vmstat");
+  CHECK (before.rss_limit > PAGE_COUNT,
+         "user pool has more than %d frames", PAGE_COUNT);
+
+  for (run = 0; run < RUNS; run++)
+    {
+      pid_t pid = fork ("child");
+      if (pid == 0)
+        touch_pages ();
+      CHECK (pid > 0, "fork child %d", run);
+      CHECK (wait (pid) == 0, "child %d wrote %d pages without eviction",
+             run, PAGE_COUNT);
+    }
+
+  CHECK (vmstat (VMSTAT_GLOBAL, &after), "vmstat after the children");
+  CHECK (after.rss < before.rss + PAGE_COUNT / 8,
+         "frames of the children went back to the pool");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(frame-table) begin
+(frame-table) vmstat
+(frame-table) user pool has more than 6400 frames
+(frame-table) fork child 0
+(frame-table) child 0 wrote 6400 pages without eviction
+(frame-table) fork child 1
+(frame-table) child 1 wrote 6400 pages without eviction
+(frame-table) fork child 2
+(frame-table) child 2 wrote 6400 pages without eviction
+(frame-table) vmstat after the children
+(frame-table) frames of the children went back to the pool
+(frame-table) end
+EOF
+pass;
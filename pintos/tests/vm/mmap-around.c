@@ -0,0 +1,54 @@
+/* Maps a file and reads the first byte of each of its first pages in
+   order.  With fault-around, one fault also maps the neighbouring
+   pages, so vmstat() must count fewer faults than pages touched, and
+   the data must match what read() returns. */
+
+#include <stdint.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 16
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+static uint64_t
+fault_cnt (const struct vmstat *st)
+{
+  return st->minor_faults + st->stack_faults + st->elf_faults
+         + st->mmap_faults + st->swapin_faults + st->wp_faults;
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  int handle;
+  void *map;
+  size_t i;
+  int sum = 0;
+
+  CHECK ((handle = open ("large.txt")) > 1, "open \"large.txt\"");
+  CHECK (read (handle, buf, sizeof buf) == (int) sizeof buf,
+         "read \"large.txt\"");
+  CHECK ((map = mmap (ACTUAL, sizeof buf, 0, handle, 0)) != MAP_FAILED,
+         "mmap \"large.txt\"");
+
+  CHECK (vmstat (VMSTAT_PROCESS, &before), "vmstat");
+  for (i = 0; i < PAGE_COUNT; i++)
+    sum += ACTUAL[i * PAGE_SIZE];
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after touching %d pages",
+         PAGE_COUNT);
+  CHECK (fault_cnt (&after) - fault_cnt (&before) < PAGE_COUNT,
+         "fewer faults than pages touched");
+
+  if (memcmp (ACTUAL, buf, sizeof buf))
+    fail ("read of mmap'd file reported bad data");
+  msg ("mapped data matches read data");
+
+  munmap (map);
+  close (handle);
+}
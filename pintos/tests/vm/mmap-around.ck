@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-around) begin
+(mmap-around) open "large.txt"
+(mmap-around) read "large.txt"
+(mmap-around) mmap "large.txt"
+(mmap-around) vmstat
+(mmap-around) vmstat after touching 16 pages
+(mmap-around) fewer faults than pages touched
+(mmap-around) mapped data matches read data
+(mmap-around) end
+EOF
+pass;
@@ -0,0 +1,45 @@
+/* Writes to a file through a mapping and flushes it with msync(),
+   then reads the data back with the read system call through a
+   second file descriptor, while the file is still mapped. */
+
+#include <mman.h>
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((void *) 0x10000000)
+#define UNMAPPED ((void *) 0x20000000)
+
+void
+test_main (void)
+{
+  int handle, reader;
+  void *map;
+  char buf[1024];
+
+  CHECK (create ("sample.txt", strlen (sample)), "create \"sample.txt\"");
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (ACTUAL, 4096, 1, handle, 0)) != MAP_FAILED,
+         "mmap \"sample.txt\"");
+  memcpy (ACTUAL, sample, strlen (sample));
+
+  CHECK (msync (map, 4096, 0) == -1, "msync with no flags must fail");
+  CHECK (msync (UNMAPPED, 4096, MS_SYNC) == -1,
+         "msync of unmapped memory must fail");
+  CHECK (msync (map, (size_t) -4096, MS_SYNC) == -1,
+         "msync of a wrapping range must fail");
+  CHECK (msync (map, 4096, MS_SYNC) == 0, "msync \"sample.txt\"");
+
+  /* Read back via read() before unmapping. */
+  CHECK ((reader = open ("sample.txt")) > 1, "open \"sample.txt\" again");
+  CHECK (read (reader, buf, strlen (sample)) == (int) strlen (sample),
+         "read \"sample.txt\"");
+  CHECK (!memcmp (buf, sample, strlen (sample)),
+         "compare read data against written data");
+  close (reader);
+
+  munmap (map);
+  close (handle);
+}
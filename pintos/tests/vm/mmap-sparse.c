@@ -0,0 +1,53 @@
+/* Maps a file at addresses that lie far apart in the address space,
+   each in a different part of the page table tree, and checks that
+   every mapping reads the file.  An address in between, where nothing
+   is mapped, must still kill the process that touches it. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define MAP_CNT 4
+
+static char *const addrs[MAP_CNT] = {
+  (char *) 0x10000000,          /* Low memory. */
+  (char *) 0x4000000000,        /* Another page directory pointer. */
+  (char *) 0x7ffffff000,        /* Last page of the first PML4 entry. */
+  (char *) 0x8000000000,        /* First page of the second one. */
+};
+
+void
+test_main (void)
+{
+  int handle[MAP_CNT];
+  pid_t child;
+  int i;
+
+  for (i = 0; i < MAP_CNT; i++)
+    {
+      CHECK ((handle[i] = open ("sample.txt")) > 1, "open \"sample.txt\"");
+      CHECK (mmap (addrs[i], 4096, 0, handle[i], 0) == addrs[i],
+             "mmap \"sample.txt\" at %p", addrs[i]);
+    }
+  for (i = 0; i < MAP_CNT; i++)
+    if (memcmp (addrs[i], sample, strlen (sample)))
+      fail ("read of mapping at %p reported bad data", addrs[i]);
+  msg ("all mappings read correctly");
+
+  munmap (addrs[1]);
+  if ((child = fork ("child")) == 0)
+    {
+      /* Neither mapped nor next to the stack. */
+      volatile char c = *addrs[1];
+      (void) c;
+      exit (0);
+    }
+  CHECK (wait (child) == -1, "touching an unmapped address killed the child");
+
+  for (i = 0; i < MAP_CNT; i++)
+    if (i != 1 && memcmp (addrs[i], sample, strlen (sample)))
+      fail ("read of mapping at %p reported bad data", addrs[i]);
+  msg ("other mappings still read correctly");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-sparse) begin
+(mmap-sparse) open "sample.txt"
+(mmap-sparse) mmap "sample.txt" at 0x10000000
+(mmap-sparse) open "sample.txt"
+(mmap-sparse) mmap "sample.txt" at 0x4000000000
+(mmap-sparse) open "sample.txt"
+(mmap-sparse) mmap "sample.txt" at 0x7ffffff000
+(mmap-sparse) open "sample.txt"
+(mmap-sparse) mmap "sample.txt" at 0x8000000000
+(mmap-sparse) all mappings read correctly
+(mmap-sparse) touching an unmapped address killed the child
+(mmap-sparse) other mappings still read correctly
+(mmap-sparse) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Maps a small file with a length far beyond its end and checks that
+   the mapping takes no memory until it is touched, that its untouched
+   pages still count as mapped when another mmap() tries to overlap
+   them, and that munmap() frees the whole range at once. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define MAP_LEN (256 * 1024 * 1024)
+
+void
+test_main (void)
+{
+  char *start = (char *) 0x10000000;
+  char *last = start + MAP_LEN - PAGE_SIZE;
+  struct vmstat before, after;
+  int handle;
+  size_t i;
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK (vmstat (VMSTAT_PROCESS, &before), "vmstat");
+  CHECK (mmap (start, MAP_LEN, 0, handle, 0) == start, "mmap 256 MB");
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after mmap");
+  CHECK (after.rss == before.rss, "mapping took no memory");
+
+  if (memcmp (start, sample, strlen (sample)))
+    fail ("read of first page reported bad data");
+  for (i = 0; i < PAGE_SIZE; i++)
+    if (last[i] != 0)
+      fail ("byte %zu of last page is not zero", i);
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after reading");
+  CHECK (after.rss - before.rss <= 2, "only the pages read are resident");
+
+  CHECK (mmap (start + 2 * PAGE_SIZE, PAGE_SIZE, 0, handle, 0) == MAP_FAILED,
+         "try to mmap over an untouched page");
+  CHECK (mmap (start - PAGE_SIZE, 2 * PAGE_SIZE, 0, handle, 0) == MAP_FAILED,
+         "try to mmap over the start");
+
+  munmap (start);
+  CHECK (mmap (start + 2 * PAGE_SIZE, PAGE_SIZE, 0, handle, 0)
+         == start + 2 * PAGE_SIZE, "mmap inside the unmapped range");
+  CHECK (mmap (last, PAGE_SIZE, 0, handle, 0) == last,
+         "mmap at the end of the unmapped range");
+  if (memcmp (start + 2 * PAGE_SIZE, sample, strlen (sample))
+      || memcmp (last, sample, strlen (sample)))
+    fail ("read of new mappings reported bad data");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-vma) begin
+(mmap-vma) open "sample.txt"
+(mmap-vma) vmstat
+(mmap-vma) mmap 256 MB
+(mmap-vma) vmstat after mmap
+(mmap-vma) mapping took no memory
+(mmap-vma) vmstat after reading
+(mmap-vma) only the pages read are resident
+(mmap-vma) try to mmap over an untouched page
+(mmap-vma) try to mmap over the start
+(mmap-vma) mmap inside the unmapped range
+(mmap-vma) mmap at the end of the unmapped range
+(mmap-vma) end
+EOF
+pass;
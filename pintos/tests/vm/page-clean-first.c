@@ -0,0 +1,62 @@
+/* Fills memory with pages whose swap copies are up to date, dirties
+   every fourth of them, and then makes room for other pages.  The
+   evictor prefers clean victims, which need no write, so while clean
+   pages are at hand the dirty ones in between are left alone and next
+   to nothing is written back. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 2560         /* Twice the user pool. */
+#define DIRTY_FROM 1536         /* Dirty every 4th page from here on. */
+#define STREAM_PAGES 512        /* Pages brought back in at the end. */
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+/* Returns the byte expected at the start of page I. */
+static char
+page_byte (size_t i)
+{
+  return i >= DIRTY_FROM && i % 4 == 0 ? ~i : i;
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after, before_g, after_g;
+  size_t i;
+
+  /* Every page gets a swap slot, and those read back last stay in
+     memory with a valid copy in swap. */
+  msg ("write %d pages", PAGE_COUNT);
+  for (i = 0; i < PAGE_COUNT; i++)
+    buf[i * PAGE_SIZE] = i;
+  msg ("read them back");
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+
+  msg ("dirty every 4th resident page");
+  for (i = DIRTY_FROM; i < PAGE_COUNT; i += 4)
+    buf[i * PAGE_SIZE] = ~i;
+
+  CHECK (vmstat (VMSTAT_PROCESS, &before), "vmstat");
+  CHECK (vmstat (VMSTAT_GLOBAL, &before_g), "global vmstat");
+  for (i = 0; i < STREAM_PAGES; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after reading");
+  CHECK (vmstat (VMSTAT_GLOBAL, &after_g), "global vmstat after reading");
+
+  CHECK (after.clean_evictions - before.clean_evictions > STREAM_PAGES / 2,
+         "clean pages were evicted");
+  CHECK (after_g.writebacks - before_g.writebacks < STREAM_PAGES / 16,
+         "few pages were written back");
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != page_byte (i))
+      fail ("data is inconsistent in page %zu", i);
+  msg ("all pages intact");
+}
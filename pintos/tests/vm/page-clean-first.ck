@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-clean-first) begin
+(page-clean-first) write 2560 pages
+(page-clean-first) read them back
+(page-clean-first) dirty every 4th resident page
+(page-clean-first) vmstat
+(page-clean-first) global vmstat
+(page-clean-first) vmstat after reading
+(page-clean-first) global vmstat after reading
+(page-clean-first) clean pages were evicted
+(page-clean-first) few pages were written back
+(page-clean-first) all pages intact
+(page-clean-first) end
+EOF
+pass;
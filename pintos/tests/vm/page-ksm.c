@@ -0,0 +1,90 @@
+/* Fills many pages with the same bytes and checks that the same-page
+   merging thread frees frames by merging them, that the merged pages
+   still read correctly, and that writing to one of them gives it back
+   a copy of its own without changing the others.
+
+   The merging thread runs at the lowest priority, so between checks
+   this test reads a large file, which blocks on the disk and lets it
+   run. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 64
+#define ROUND_LIMIT 50
+
+static char buf[(PAGE_COUNT + 1) * PAGE_SIZE];
+static char block[512];
+
+/* Byte I of every page. */
+static char
+pattern (size_t i)
+{
+  return (char) (i * 7 + 1);
+}
+
+/* Reads all of "large.txt" once. */
+static void
+read_large (void)
+{
+  int handle;
+
+  if ((handle = open ("large.txt")) < 2)
+    fail ("open \"large.txt\" failed");
+  while (read (handle, block, sizeof block) > 0)
+    continue;
+  close (handle);
+}
+
+/* Checks that every page but SKIP holds the pattern. */
+static void
+verify (size_t skip)
+{
+  size_t i, j;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (i != skip)
+      for (j = 0; j < PAGE_SIZE; j++)
+        if (buf[i * PAGE_SIZE + j] != pattern (j))
+          fail ("byte %zu of page %zu is wrong", j, i);
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  char *pages;
+  size_t i, j;
+  int round;
+
+  /* Only pages wholly inside BUF are sure not to share with other data. */
+  pages = (char *) (((uintptr_t) buf + PAGE_SIZE - 1)
+                    & ~(uintptr_t) (PAGE_SIZE - 1));
+
+  CHECK (vmstat (VMSTAT_GLOBAL, &before), "vmstat");
+  for (i = 0; i < PAGE_COUNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      pages[i * PAGE_SIZE + j] = pattern (j);
+  msg ("filled %d pages with the same bytes", PAGE_COUNT);
+
+  for (round = 0; round < ROUND_LIMIT; round++)
+    {
+      read_large ();
+      if (!vmstat (VMSTAT_GLOBAL, &after))
+        fail ("vmstat failed");
+      if (after.ksm_merged - before.ksm_merged >= PAGE_COUNT / 2)
+        break;
+    }
+  CHECK (after.ksm_merged - before.ksm_merged >= PAGE_COUNT / 2,
+         "at least half of the pages were merged");
+  verify (PAGE_COUNT);
+  msg ("merged pages read correctly");
+
+  pages[3 * PAGE_SIZE] = 'x';
+  CHECK (pages[3 * PAGE_SIZE] == 'x', "write to a merged page");
+  verify (3);
+  msg ("other pages are unchanged");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-ksm) begin
+(page-ksm) vmstat
+(page-ksm) filled 64 pages with the same bytes
+(page-ksm) at least half of the pages were merged
+(page-ksm) merged pages read correctly
+(page-ksm) write to a merged page
+(page-ksm) other pages are unchanged
+(page-ksm) end
+EOF
+pass;
@@ -0,0 +1,63 @@
+/* Writes pages in bursts that are smaller than the gap between the
+   page-out daemon's watermarks, and gives the daemon time to run in
+   between.  The daemon then frees frames ahead of the faults, so most
+   evictions, and the writes they need, are done by it rather than on
+   the fault path. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 2560         /* Twice the user pool. */
+#define BURST_PAGES 128         /* Less than wm-high minus wm-low. */
+#define LOW_WATERMARK 64        /* As given on the kernel command line. */
+#define WAIT_LIMIT 100000
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+/* Spins until the page-out daemon has brought free frames well above
+   the low watermark, or for WAIT_LIMIT rounds. */
+static void
+wait_for_daemon (void)
+{
+  struct vmstat st;
+  int n;
+
+  for (n = 0; n < WAIT_LIMIT; n++)
+    {
+      if (!vmstat (VMSTAT_GLOBAL, &st))
+        fail ("vmstat failed");
+      if (st.rss_limit - st.rss >= 2 * LOW_WATERMARK)
+        break;
+    }
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  uint64_t evictions;
+  size_t i;
+
+  CHECK (vmstat (VMSTAT_GLOBAL, &before), "vmstat");
+  msg ("write %d pages in bursts of %d", PAGE_COUNT, BURST_PAGES);
+  for (i = 0; i < PAGE_COUNT; i++)
+    {
+      buf[i * PAGE_SIZE] = i;
+      if (i % BURST_PAGES == BURST_PAGES - 1)
+        wait_for_daemon ();
+    }
+  CHECK (vmstat (VMSTAT_GLOBAL, &after), "vmstat after writing");
+
+  evictions = (after.clean_evictions + after.dirty_evictions)
+              - (before.clean_evictions + before.dirty_evictions);
+  CHECK (evictions > 0, "pages were evicted");
+  CHECK (after.pageout_evictions - before.pageout_evictions > evictions / 2,
+         "most evictions were done by the page-out daemon");
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+  msg ("all pages intact");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-pageout) begin
+(page-pageout) vmstat
+(page-pageout) write 2560 pages in bursts of 128
+(page-pageout) vmstat after writing
+(page-pageout) pages were evicted
+(page-pageout) most evictions were done by the page-out daemon
+(page-pageout) all pages intact
+(page-pageout) end
+EOF
+pass;
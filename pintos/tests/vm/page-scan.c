@@ -0,0 +1,61 @@
+/* Builds a working set that is used over and over while memory is
+   under pressure, then streams once through more memory than the user
+   pool holds.  CLOCK-Pro only evicts cold pages, and the pages of a
+   one-time scan never get hot, so the working set must still be
+   resident afterwards.  A plain clock would have evicted all of it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define WS_PAGES 256            /* Working set. */
+#define WARM_ROUNDS 8
+#define WARM_PAGES 512          /* New pages written in each round. */
+#define SCAN_PAGES 2560         /* Twice the user pool. */
+
+static char ws[WS_PAGES * PAGE_SIZE];
+static char warm[WARM_ROUNDS * WARM_PAGES * PAGE_SIZE];
+static char scan[SCAN_PAGES * PAGE_SIZE];
+
+/* Reads every page of the working set and checks its contents. */
+static void
+use_working_set (void)
+{
+  size_t i;
+
+  for (i = 0; i < WS_PAGES; i++)
+    if (ws[i * PAGE_SIZE] != (char) i)
+      fail ("working set is inconsistent in page %zu", i);
+}
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  size_t round, i;
+
+  for (i = 0; i < WS_PAGES; i++)
+    ws[i * PAGE_SIZE] = i;
+
+  /* Evictions move the clock hands, so the working set is referenced
+     again while they pass and turns hot. */
+  msg ("warm up the working set");
+  for (round = 0; round < WARM_ROUNDS; round++)
+    {
+      char *p = warm + round * WARM_PAGES * PAGE_SIZE;
+      for (i = 0; i < WARM_PAGES; i++)
+        p[i * PAGE_SIZE] = i;
+      use_working_set ();
+    }
+
+  msg ("scan %d pages once", SCAN_PAGES);
+  for (i = 0; i < SCAN_PAGES; i++)
+    scan[i * PAGE_SIZE] = i;
+
+  CHECK (vmstat (VMSTAT_PROCESS, &before), "vmstat");
+  use_working_set ();
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after using the working set");
+  CHECK (after.swapin_faults - before.swapin_faults < WS_PAGES / 16,
+         "working set survived the scan");
+}
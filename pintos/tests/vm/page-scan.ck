@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-scan) begin
+(page-scan) warm up the working set
+(page-scan) scan 2560 pages once
+(page-scan) vmstat
+(page-scan) vmstat after using the working set
+(page-scan) working set survived the scan
+(page-scan) end
+EOF
+pass;
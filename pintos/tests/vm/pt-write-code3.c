@@ -0,0 +1,15 @@
+/* Try to write to the code segment by reading from the keyboard
+   with a system call.  The process must be terminated with -1 exit
+   code, before any input is consumed. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  read (STDIN_FILENO, (void *) test_main, 1);
+  fail ("survived reading keyboard input into code segment");
+}
@@ -0,0 +1,38 @@
+/* Writes twice the user pool one page after another, so the pages are
+   evicted in order into neighbouring swap slots, then reads the first
+   half back in the same order.  Swap-in reads the following slots of
+   the cluster with the same command and maps them right away, so far
+   fewer faults than pages are needed. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 2560         /* Twice the user pool. */
+#define READ_PAGES (PAGE_COUNT / 2)
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  size_t i;
+
+  msg ("write %d pages", PAGE_COUNT);
+  for (i = 0; i < PAGE_COUNT; i++)
+    buf[i * PAGE_SIZE] = i;
+
+  CHECK (vmstat (VMSTAT_PROCESS, &before), "vmstat");
+  msg ("read %d pages back in order", READ_PAGES);
+  for (i = 0; i < READ_PAGES; i++)
+    if (buf[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after reading");
+
+  CHECK (after.swapin_faults > before.swapin_faults,
+         "pages were swapped in");
+  CHECK (after.swapin_faults - before.swapin_faults < READ_PAGES / 2,
+         "each swap-in fault brought in several pages");
+}
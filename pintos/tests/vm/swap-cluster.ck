@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-cluster) begin
+(swap-cluster) write 2560 pages
+(swap-cluster) vmstat
+(swap-cluster) read 1280 pages back in order
+(swap-cluster) vmstat after reading
+(swap-cluster) pages were swapped in
+(swap-cluster) each swap-in fault brought in several pages
+(swap-cluster) end
+EOF
+pass;
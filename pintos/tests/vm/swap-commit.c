@@ -0,0 +1,61 @@
+/* Fills more than half of what RAM and swap can back with anonymous
+   pages, swapping some of them out and back in, then forks.  The
+   child would need as much again, which cannot be backed, so fork()
+   must fail and the parent must go on with its data intact instead
+   of being killed when swap runs out. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (5 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+/* Checks that every page of big_chunk holds what write_pages() put
+   there. */
+static void
+check_pages (void)
+{
+  size_t i;
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (big_chunk[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+}
+
+void
+test_main (void)
+{
+  pid_t pid;
+  size_t i;
+
+  msg ("write %d pages", PAGE_COUNT);
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunk[i * PAGE_SIZE] = i;
+  check_pages ();
+
+  pid = fork ("child");
+  if (pid == 0)
+    {
+      /* Should not get here: the child's copy cannot be backed. */
+      exit (162);
+    }
+  if (pid != -1)
+    {
+      wait (pid);
+      fail ("fork() returned %d, not -1", pid);
+    }
+  msg ("fork failed");
+
+  /* Whatever the failed fork() reserved was given back, and the
+     parent can still page through all of its memory. */
+  check_pages ();
+  for (i = 0; i < PAGE_COUNT; i++)
+    big_chunk[i * PAGE_SIZE] = i;
+  check_pages ();
+  msg ("parent data intact");
+}
@@ -0,0 +1,12 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-commit) begin
+(swap-commit) write 1280 pages
+(swap-commit) fork failed
+(swap-commit) parent data intact
+(swap-commit) end
+EOF
+pass;
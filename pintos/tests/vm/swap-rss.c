@@ -0,0 +1,44 @@
+/* Limits the resident set with setrss() and writes to more pages than
+   the limit allows, which has to evict some of the process's own
+   pages although memory is plentiful.  Then checks that every page
+   comes back with the data written to it. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 128
+#define RSS_LIMIT 32
+
+static char buf[PAGE_COUNT * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct vmstat st;
+  size_t i;
+
+  setrss (RSS_LIMIT);
+  CHECK (vmstat (VMSTAT_PROCESS, &st), "vmstat");
+  CHECK (st.rss_limit == RSS_LIMIT, "resident set limit is %d pages",
+         RSS_LIMIT);
+
+  msg ("write %d pages", PAGE_COUNT);
+  for (i = 0; i < PAGE_COUNT; i++) {
+    buf[i * PAGE_SIZE] = i;
+    buf[i * PAGE_SIZE + PAGE_SIZE / 2] = ~i;
+  }
+
+  msg ("check %d pages", PAGE_COUNT);
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (buf[i * PAGE_SIZE] != (char) i
+        || buf[i * PAGE_SIZE + PAGE_SIZE / 2] != (char) ~i)
+      fail ("data is inconsistent in page %zu", i);
+
+  CHECK (vmstat (VMSTAT_PROCESS, &st), "vmstat after the writes");
+  CHECK (st.clean_evictions + st.dirty_evictions > 0,
+         "own pages were evicted");
+  CHECK (st.swapin_faults > 0, "evicted pages were swapped in");
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(swap-rss) begin
+(swap-rss) vmstat
+(swap-rss) resident set limit is 32 pages
+(swap-rss) write 128 pages
+(swap-rss) check 128 pages
+(swap-rss) vmstat after the writes
+(swap-rss) own pages were evicted
+(swap-rss) evicted pages were swapped in
+(swap-rss) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Swaps anonymous pages through the compressed pool in front of the
+   swap disk.  Even pages hold a single byte and compress well, odd
+   pages are filled with pseudo-random bytes and do not, so both the
+   pool and the disk are used.  Every page must come back intact. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define ONE_MB (1 << 20)
+#define CHUNK_SIZE (6 * ONE_MB)
+#define PAGE_COUNT (CHUNK_SIZE / PAGE_SIZE)
+
+static char big_chunk[CHUNK_SIZE];
+
+/* Returns the byte at OFS of the contents of page IDX. */
+static char
+page_byte (size_t idx, size_t ofs)
+{
+  uint32_t x;
+
+  if (idx % 2 == 0)
+    return ofs == 0 ? (char) idx : 0;
+  x = (idx * PAGE_SIZE + ofs) * 2654435761u;
+  return x >> 24;
+}
+
+void
+test_main (void)
+{
+  size_t i, j;
+
+  for (i = 0; i < PAGE_COUNT; i++) {
+    char *page = big_chunk + i * PAGE_SIZE;
+    if (i % 512 == 0)
+      msg ("write page %zu", i);
+    for (j = 0; j < PAGE_SIZE; j++)
+      page[j] = page_byte (i, j);
+  }
+
+  for (i = 0; i < PAGE_COUNT; i++) {
+    char *page = big_chunk + i * PAGE_SIZE;
+    for (j = 0; j < PAGE_SIZE; j++)
+      if (page[j] != page_byte (i, j))
+        fail ("data is inconsistent at byte %zu of page %zu", j, i);
+    if (i % 512 == 0)
+      msg ("check consistency in page %zu", i);
+  }
+}
@@ -0,0 +1,48 @@
+/* Reads and then writes pages of the BSS that were never touched, and
+   checks that vmstat() counts the faults: a read maps the shared zero
+   page as a minor fault, and the first write to it is a write-protect
+   fault that gives the page a frame of its own. */
+
+#include <stdint.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define PAGE_COUNT 16
+
+static char buf[(PAGE_COUNT + 1) * PAGE_SIZE];
+
+void
+test_main (void)
+{
+  struct vmstat before, after;
+  volatile char *pages;
+  size_t i;
+  int sum = 0;
+
+  /* Only pages wholly inside BUF are sure to be untouched. */
+  pages = (char *) (((uintptr_t) buf + PAGE_SIZE - 1)
+                    & ~(uintptr_t) (PAGE_SIZE - 1));
+
+  CHECK (vmstat (VMSTAT_PROCESS, &before), "vmstat");
+  for (i = 0; i < PAGE_COUNT; i++)
+    sum += pages[i * PAGE_SIZE];
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after reading");
+  CHECK (sum == 0, "untouched pages read as zeros");
+  CHECK (after.minor_faults - before.minor_faults >= PAGE_COUNT,
+         "reads counted as minor faults");
+
+  before = after;
+  for (i = 0; i < PAGE_COUNT; i++)
+    pages[i * PAGE_SIZE] = i;
+  CHECK (vmstat (VMSTAT_PROCESS, &after), "vmstat after writing");
+  CHECK (after.wp_faults - before.wp_faults >= PAGE_COUNT,
+         "writes counted as write-protect faults");
+  CHECK (after.rss - before.rss >= PAGE_COUNT,
+         "resident set grew by the pages written");
+
+  for (i = 0; i < PAGE_COUNT; i++)
+    if (pages[i * PAGE_SIZE] != (char) i)
+      fail ("data is inconsistent in page %zu", i);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(vmstat-fault) begin
+(vmstat-fault) vmstat
+(vmstat-fault) vmstat after reading
+(vmstat-fault) untouched pages read as zeros
+(vmstat-fault) reads counted as minor faults
+(vmstat-fault) vmstat after writing
+(vmstat-fault) writes counted as write-protect faults
+(vmstat-fault) resident set grew by the pages written
+(vmstat-fault) end
+EOF
+pass;
@@ -31,9 +31,11 @@
 #include "tests/threads/tests.h"
 #ifdef VM
 #include "vm/vm.h"
+#include "vm/zswap.h"
 #endif
 #ifdef FILESYS
 #include "devices/disk.h"
+#include "filesys/cache.h"
 #include "filesys/filesys.h"
 #include "filesys/fsutil.h"
 #endif
@@ -141,7 +143,11 @@ bss_init(void) {
 
 /* Populates the page table with the kernel virtual mapping,
  * and then sets up the CPU to use the new page directory.
- * Points base_pml4 to the pml4 it creates. */
+ * Points base_pml4 to the pml4 it creates.
+ * Every 2 MiB block of physical memory that is wholly present and
+ * holds no kernel text is mapped with a single huge-page PDE, which
+ * saves the page tables and most of the TLB entries of the direct map.
+ * The rest is mapped page by page, so the text can be read-only. */
 static void
 paging_init(uint64_t mem_end) {
   uint64_t *pml4, *pte;
@@ -149,17 +155,30 @@ paging_init(uint64_t mem_end) {
   pml4 = base_pml4 = palloc_get_page(PAL_ASSERT | PAL_ZERO);
 
   extern char start, _end_kernel_text;
+  uint64_t text_start = vtop(&start);
+  uint64_t text_end = vtop(&_end_kernel_text);
+
   // Maps physical address [0 ~ mem_end] to
   //   [LOADER_KERN_BASE ~ LOADER_KERN_BASE + mem_end].
-  for (uint64_t pa = 0; pa < mem_end; pa += PGSIZE) {
+  for (uint64_t pa = 0; pa < mem_end;) {
     uint64_t va = (uint64_t)ptov(pa);
 
+    if ((pa & HUGE_PGMASK) == 0 && pa + HUGE_PGSIZE <= mem_end &&
+        (pa + HUGE_PGSIZE <= text_start || text_end <= pa)) {
+      if ((pte = pml4e_walk_pde(pml4, va, 1)) != NULL) {
+        *pte = pa | PTE_P | PTE_W | PTE_PS;
+        pa += HUGE_PGSIZE;
+        continue;
+      }
+    }
+
     perm = PTE_P | PTE_W;
-    if ((uint64_t)&start <= va && va < (uint64_t)&_end_kernel_text)
+    if (text_start <= pa && pa < text_end)
       perm &= ~PTE_W;
 
     if ((pte = pml4e_walk(pml4, va, 1)) != NULL)
       *pte = pa | perm;
+    pa += PGSIZE;
   }
 
   // reload cr3
@@ -215,6 +234,8 @@ parse_options(char** argv) {
 #ifdef FILESYS
 		else if (!strcmp(name, "-f"))
       format_filesys = true;
+    else if (!strcmp(name, "-bc"))
+      cache_size = atoi(value);
 #endif
     else if (!strcmp(name, "-rs"))
       random_init(atoi(value));
@@ -225,6 +246,26 @@ parse_options(char** argv) {
       user_page_limit = atoi(value);
     else if (!strcmp(name, "-threads-tests"))
       thread_tests = true;
+#endif
+#ifdef VM
+    else if (!strcmp(name, "-rp")) {
+      if (value == NULL || !vm_set_replace_policy(value))
+        PANIC("unknown page replacement policy `%s'", value);
+    }
+    else if (!strcmp(name, "-wm-low"))
+      vm_low_watermark = atoi(value);
+    else if (!strcmp(name, "-wm-high"))
+      vm_high_watermark = atoi(value);
+    else if (!strcmp(name, "-fa"))
+      vm_set_fault_around(atoi(value));
+    else if (!strcmp(name, "-ksm"))
+      vm_ksm_pages = atoi(value);
+    else if (!strcmp(name, "-zswap"))
+      zswap_pages = atoi(value);
+    else if (!strcmp(name, "-load")) {
+      if (value == NULL || !vm_set_load_policy(value))
+        PANIC("unknown executable load policy `%s'", value);
+    }
 #endif
     else
       PANIC("unknown option `%s' (use -h for help)", name);
@@ -321,10 +362,20 @@ usage(void) {
       "  -h                 Print this help message and power off.\n"
       "  -q                 Power off VM after actions or on panic.\n"
       "  -f                 Format file system disk during startup.\n"
+      "  -bc=SECTORS        Size of the file system buffer cache.\n"
       "  -rs=SEED           Set random number seed to SEED.\n"
       "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
       "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+      "  -rp=POLICY         Page replacement: clock or clock-pro (default).\n"
+      "  -wm-low=PAGES      Wake the page-out daemon below PAGES free frames.\n"
+      "  -wm-high=PAGES     Page-out daemon stops at PAGES free frames.\n"
+      "  -fa=PAGES          Fault-around window for file-backed pages.\n"
+      "  -ksm=PAGES         Merge identical anon pages, scanning PAGES per pass.\n"
+      "  -zswap=PAGES       Compress swapped-out pages into a PAGES-page pool.\n"
+      "  -load=POLICY       Executable pages: lazy (default), eager or hybrid.\n"
 #endif
       );
   power_off();
@@ -352,10 +403,17 @@ print_stats(void) {
   thread_print_stats();
 #ifdef FILESYS
   disk_print_stats();
+  cache_print_stats();
 #endif
   console_print_stats();
   kbd_print_stats();
 #ifdef USERPROG
   exception_print_stats();
 #endif
+#ifdef VM
+  vm_print_stats();
+#ifdef EFILESYS
+  page_cache_print_stats();
+#endif
+#endif
 }
\ No newline at end of file
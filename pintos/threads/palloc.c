@@ -296,6 +296,30 @@ palloc_get_page (enum palloc_flags flags) {
 	return palloc_get_multiple (flags, 1);
 }
 
+/* Returns the kernel virtual address of the first page of the
+   user pool and stores the number of pages it spans in *PAGE_CNT.
+   The span includes holes in physical memory, which are simply
+   never handed out.  Must be called after palloc_init(). */
+void *
+palloc_user_pool_base (size_t *page_cnt) {
+	ASSERT (user_pool.used_map != NULL);
+
+	*page_cnt = bitmap_size (user_pool.used_map);
+	return user_pool.base;
+}
+
+/* Returns the number of free pages in the user pool. */
+size_t
+palloc_user_free_cnt (void) {
+	size_t cnt;
+
+	lock_acquire (&user_pool.lock);
+	cnt = bitmap_count (user_pool.used_map, 0,
+			bitmap_size (user_pool.used_map), false);
+	lock_release (&user_pool.lock);
+	return cnt;
+}
+
 /* Frees the PAGE_CNT pages starting at PAGES. */
 void
 palloc_free_multiple (void *pages, size_t page_cnt) {
@@ -221,6 +221,14 @@ static void __do_fork(void* aux) {
   process_activate(current);
 #ifdef VM
   supplemental_page_table_init(&current->spt);
+  current->rss_limit = parent->rss_limit;
+  /* 실행 파일도 자식 전용 핸들로 다시 열어 둠 (파일 페이지가 참조) */
+  if (parent->running_file != NULL) {
+    current->running_file = file_reopen(parent->running_file);
+    if (current->running_file == NULL) goto error;
+    file_deny_write(current->running_file);
+  }
+  if (!vma_fork(parent)) goto error;
   if (!supplemental_page_table_copy(&current->spt, &parent->spt)) goto error;
 #else
   if (!pml4_for_each(parent->pml4, duplicate_pte, parent)) goto error;
@@ -454,10 +462,10 @@ void process_exit(void) {
     curr->fdt = NULL;
   }
 
-  /* 프로세스 종료와 함께 실행 중인 파일 정보 해제 */
+  /* 프로세스 종료와 함께 실행 파일 쓰기 허용. 파일 자체는 이를 참조하는
+   * 페이지가 모두 사라진 뒤 process_cleanup()에서 닫음 */
   if (curr->running_file != NULL) {
-    file_close(curr->running_file);
-    curr->running_file = NULL;
+    file_allow_write(curr->running_file);
   }
 #endif
 
@@ -465,8 +473,8 @@ void process_exit(void) {
   // 모든 mmap 영역 해제
   while (!list_empty(&curr->mmaps)) {
     struct list_elem* e = list_begin(&curr->mmaps);
-    struct mmap_region* region = list_entry(e, struct mmap_region, elem);
-    do_munmap(region->base);
+    struct vma* vma = list_entry(e, struct vma, elem);
+    do_munmap(vma->base);
   }
 #endif
 
@@ -491,6 +499,12 @@ static void process_cleanup(void) {
 #ifdef VM
   supplemental_page_table_kill(&curr->spt);
 #endif
+#ifdef USERPROG
+  if (curr->running_file != NULL) {
+    file_close(curr->running_file);
+    curr->running_file = NULL;
+  }
+#endif
 
   uint64_t* pml4;
   /* Destroy the current process's page directory and switch back
@@ -595,6 +609,10 @@ static bool load(const char* file_name, struct intr_frame* if_) {
   t->pml4 = pml4_create();
   if (t->pml4 == NULL) return success;
   process_activate(thread_current());
+#ifdef VM
+  t->vmstat.exec_faults = 0;
+  t->vmstat.prefaulted = 0;
+#endif
 
   /* Open executable file. */
   lock_acquire(&filesys_lock);
@@ -662,6 +680,9 @@ static bool load(const char* file_name, struct intr_frame* if_) {
           if (!load_segment(file, file_page, (void*)mem_page, read_bytes,
                             zero_bytes, writable))
             goto done;
+#ifdef VM
+          vm_prefault_segment((void*)mem_page, read_bytes, writable);
+#endif
         } else
           goto done;
         break;
@@ -907,8 +928,10 @@ static bool load_segment(struct file* file, off_t ofs, uint8_t* upage,
     aux->zero_bytes = page_zero_bytes;
     aux->writable = writable;
 
-    /* UNINIT 엔트리 등록 */
-    if (!vm_alloc_page_with_initializer(VM_ANON, upage, writable,
+    /* UNINIT 엔트리 등록. 읽기 전용 페이지는 파일 페이지로 두어
+     * 다른 프로세스와 frame을 공유하고, eviction 시 swap 없이 버림 */
+    enum vm_type type = writable ? VM_ANON : VM_FILE;
+    if (!vm_alloc_page_with_initializer(type, upage, writable,
                                         lazy_load_segment, aux)) {
       free(aux);
       return false;
@@ -1,5 +1,6 @@
 #include "userprog/syscall.h"
 
+#include <mman.h>
 #include <stdio.h>
 #include <syscall-nr.h>
 
@@ -40,6 +41,7 @@ void seek(int fd, unsigned position);
 unsigned tell(int fd);
 void close(int fd);
 bool copy_in(void* dst, const void* usrc, size_t size);
+bool copy_out(void* udst, const void* src, size_t size);
 bool copy_in_string(char* dst, const char* us, size_t dst_sz, size_t* out_len);
 int exec(const char* cmd_line);
 pid_t fork(const char* thread_name, struct intr_frame* if_);
@@ -47,6 +49,9 @@ int wait(pid_t pid);
 void* mmap(void* addr, size_t length, int writable, int fd, off_t offset);
 void munmap(void* addr);
 int dup2(int oldfd, int newfd);
+bool vmstat(int scope, struct vmstat* ust);
+int msync(void* addr, size_t length, int flags);
+void setrss(size_t pages);
 
 #define MSR_STAR 0xc0000081         /* Segment selector msr */
 #define MSR_LSTAR 0xc0000082        /* Long mode SYSCALL target */
@@ -154,6 +159,18 @@ void syscall_handler(struct intr_frame* f UNUSED) {
       f->R.rax = dup2(oldfd, newfd);
       break;
     }
+    case SYS_VMSTAT: {
+      f->R.rax = vmstat((int)f->R.rdi, (struct vmstat*)f->R.rsi);
+      break;
+    }
+    case SYS_MSYNC: {
+      f->R.rax = msync((void*)f->R.rdi, (size_t)f->R.rsi, (int)f->R.rdx);
+      break;
+    }
+    case SYS_SETRSS: {
+      setrss((size_t)f->R.rdi);
+      break;
+    }
     default: {
       printf("system call 오류 : 알 수 없는 시스템콜 번호 %d\n",
              syscall_number);
@@ -336,26 +353,22 @@ int read(int fd, void* buffer, unsigned size) {
   for (void* page = start_page; page <= end_page; page += PGSIZE) {
     struct page* p = spt_find_page(&curr->spt, page);
     if (p == NULL) {
-      // 스택 접근일 경우 페이지 폴트에서 처리
+      // 스택 접근일 경우 아래 pin에서 페이지를 만듦
       if (is_stack_addr(page, thread_current()->user_rsp)) {
         continue;
       } else {
         exit(-1);
       }
     }
-    if (p && !p->writable) {
-      exit(-1);
-    }
-
-    if (p && p->frame == NULL) {
-      if (!vm_claim_page(page)) {
-        exit(-1);
-      }
-    }
   }
 
   int bytes_read = 0;
 
+  // 커널이 버퍼에 쓰는 동안 폴트가 나지 않도록 frame을 pin
+  // (읽기 전용 페이지면 여기서 실패. filesys_lock 보유 중 폴트도 막음)
+  if (!vm_pin_buffer(buffer, size)) {
+    exit(-1);
+  }
   if (file == STDIN_MARKER) {
     for (unsigned i = 0; i < size; i++) {
       *((uint8_t*)buffer + i) = (uint8_t)input_getc();
@@ -366,6 +379,7 @@ int read(int fd, void* buffer, unsigned size) {
     bytes_read = file_read(file, buffer, size);
     lock_release(&filesys_lock);
   }
+  vm_unpin_buffer(buffer, size);
 
   return bytes_read;
 }
@@ -487,6 +501,28 @@ bool copy_in(void* dst, const void* usrc, size_t size) {
   return true;
 }
 
+/* 커널 버퍼 `src`의 size 바이트를 유저 포인터 `udst`로 복사한다.
+   쓰기 가능한 유저 페이지가 아니면 false를 반환한다. */
+bool copy_out(void* udst, const void* src, size_t size) {
+  char* dst = (char*)udst;
+
+  if (!is_user_vaddr(dst) || !is_user_vaddr(dst + size - 1)) {
+    return false;
+  }
+
+  void* start_page = pg_round_down(dst);
+  void* end_page = pg_round_down(dst + size - 1);
+
+  for (void* page = start_page; page <= end_page; page += PGSIZE) {
+    if (!vm_claim_page_for_write(page)) {
+      return false;
+    }
+  }
+
+  memcpy(dst, src, size);
+  return true;
+}
+
 /*
  * copy_in_string()
  * - 유저 포인터 us가 가리키는 NUL-종단 문자열을 커널 버퍼 dst로 복사한다.
@@ -619,3 +655,40 @@ int dup2(int oldfd, int newfd) {
 
   return newfd;
 }
+
+/* 가상 메모리 통계를 유저 버퍼 ust로 복사한다.
+   scope는 VMSTAT_PROCESS(현재 프로세스) 또는 VMSTAT_GLOBAL(시스템 전체). */
+bool vmstat(int scope, struct vmstat* ust) {
+  struct vmstat st;
+
+  if (scope != VMSTAT_PROCESS && scope != VMSTAT_GLOBAL) return false;
+  if (ust == NULL) exit(-1);
+
+  vm_get_stats(scope, &st);
+  if (!copy_out(ust, &st, sizeof st)) exit(-1);
+  return true;
+}
+
+/* 매핑된 범위의 dirty 페이지를 파일에 write back 한다.
+   flags는 MS_SYNC(완료까지 대기) 또는 MS_ASYNC. 성공 시 0, 실패 시 -1. */
+int msync(void* addr, size_t length, int flags) {
+  if (flags != MS_SYNC && flags != MS_ASYNC) return -1;
+  if (addr == NULL || pg_ofs(addr) != 0) return -1;
+  // addr + length가 넘쳐 낮은 주소로 돌아오는 경우도 거부
+  if (!is_user_vaddr(addr) ||
+      length > (uintptr_t)KERN_BASE - (uintptr_t)addr) {
+    return -1;
+  }
+  return do_msync(addr, length, flags);
+}
+
+/* 현재 프로세스의 resident set을 pages 페이지로 제한한다. 0이면 제한 해제.
+   넘은 만큼은 이후 fault에서 자기 페이지를 내보내며 줄어든다. fork한 자식에게
+   상속되고 exec 후에도 유지된다. VM이 없으면 아무 일도 하지 않는다. */
+void setrss(size_t pages) {
+#ifdef VM
+  thread_current()->rss_limit = pages;
+#else
+  (void)pages;
+#endif
+}
@@ -1,9 +1,15 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
+#include <stdio.h>
+#include <string.h>
+
 #include "devices/disk.h"
 #include "lib/kernel/bitmap.h"
+#include "threads/malloc.h"
+#include "threads/mmu.h"
 #include "threads/vaddr.h"
 #include "vm/vm.h"
+#include "vm/zswap.h"
 
 /* DO NOT MODIFY BELOW LINE */
 static struct disk *swap_disk;
@@ -11,8 +17,25 @@ static bool anon_swap_in(struct page *page, void *kva);
 static bool anon_swap_out(struct page *page);
 static void anon_destroy(struct page *page);
 
+/* Sectors per swap slot; one slot holds one page. */
+#define SECTORS_PER_SLOT (PGSIZE / DISK_SECTOR_SIZE)
+/* Most slots read or written by a single swap command. */
+#define SWAP_CLUSTER 8
+
 // 스왑 슬롯 사용 여부 추적용
 static struct bitmap *swap_table;
+// 슬롯별 참조 수 (fork 후 부모/자식이 같은 슬롯을 공유할 수 있음)
+static unsigned *swap_refs;
+// 슬롯을 혼자 쓰는 page (공유 중이면 NULL). swap-in 클러스터링에 사용
+static struct page **swap_owner;
+// next-fit 할당 위치. 함께 쫓겨나는 페이지가 연속된 슬롯에 놓이게 함
+static size_t swap_cursor;
+static struct lock swap_lock;
+
+// swap cache 통계
+static uint64_t swap_cache_hits;   // 쓰기 없이 끝난 eviction 수
+static uint64_t swap_cache_stale;  // dirty로 낡아서 다시 쓴 사본 수
+static uint64_t swap_cache_reclaimed;  // swap이 차서 회수한 cache 슬롯 수
 
 /* DO NOT MODIFY this struct */
 static const struct page_operations anon_ops = {
@@ -35,10 +58,103 @@ void vm_anon_init(void) {
   disk_sector_t swap_size = disk_size(swap_disk);
 
   // 슬롯 수 계산
-  size_t slot_count = (swap_size / 8);  // 8섹터 = 1슬롯 = 1페이지
+  size_t slot_count = swap_size / SECTORS_PER_SLOT;  // 8섹터 = 1슬롯 = 1페이지
 
   // 비트맵 생성. 각 비트는 하나의 슬롯을 나타냄
   swap_table = bitmap_create(slot_count);
+  swap_refs = calloc(slot_count, sizeof *swap_refs);
+  swap_owner = calloc(slot_count, sizeof *swap_owner);
+  if (swap_table == NULL || swap_refs == NULL || swap_owner == NULL) {
+    PANIC("swap table allocation failed");
+  }
+  lock_init(&swap_lock);
+  zswap_init(slot_count);
+}
+
+/* Allocates CNT contiguous swap slots for PAGES, one reference each.
+ * Allocation is next-fit, so pages swapped out one after another end up
+ * next to each other and can be read back with one command.
+ * Returns the first slot, or BITMAP_ERROR if swap is full or missing. */
+static size_t swap_slots_get(struct page **pages, size_t cnt) {
+  if (swap_table == NULL) return BITMAP_ERROR;
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    lock_acquire(&swap_lock);
+    size_t slot = bitmap_scan_and_flip(swap_table, swap_cursor, cnt, false);
+    if (slot == BITMAP_ERROR) {
+      slot = bitmap_scan_and_flip(swap_table, 0, cnt, false);
+    }
+    if (slot != BITMAP_ERROR) {
+      for (size_t i = 0; i < cnt; i++) {
+        swap_refs[slot + i] = 1;
+        swap_owner[slot + i] = pages[i];
+      }
+      swap_cursor = slot + cnt;
+    }
+    lock_release(&swap_lock);
+    if (slot != BITMAP_ERROR) return slot;
+
+    // 꽉 찼으면 메모리에 올라와 있는 페이지의 swap cache 슬롯을 회수하고 재시도
+    if (vm_reclaim_swap_cache() == 0) break;
+  }
+  return BITMAP_ERROR;
+}
+
+/* Frees the swap-cache slots of resident pages so that evicted pages can
+ * use them.  Only slots a single page owns are taken, and only from pages
+ * whose frame is neither pinned nor being written back, since a writer
+ * uses the slot without holding swap_lock.  Such a page simply looks
+ * dirty to the next eviction and is written to a fresh slot.  Returns the
+ * number of slots freed.  Must be called with frame_lock held, so no
+ * evictor is relying on the copies being taken away. */
+size_t anon_reclaim_swap_cache(void) {
+  size_t freed = 0;
+
+  if (swap_table == NULL) return 0;
+
+  for (size_t slot = 0; slot < bitmap_size(swap_table); slot++) {
+    lock_acquire(&swap_lock);
+    struct page *page = swap_owner[slot];
+    bool reclaim = swap_refs[slot] == 1 && page != NULL &&
+                   page->frame != NULL && page->frame->pin_cnt == 0 &&
+                   !page->frame->io && page->anon.swap_slot == slot;
+    if (reclaim) {
+      page->anon.swap_slot = BITMAP_ERROR;
+      swap_refs[slot] = 0;
+      swap_owner[slot] = NULL;
+      bitmap_reset(swap_table, slot);
+    }
+    lock_release(&swap_lock);
+
+    if (reclaim) {
+      zswap_drop(slot);
+      freed++;
+    }
+  }
+  swap_cache_reclaimed += freed;
+  return freed;
+}
+
+/* Drops one reference to SLOT, freeing it with the last one. */
+static void swap_slot_put(size_t slot) {
+  lock_acquire(&swap_lock);
+  ASSERT(swap_refs[slot] > 0);
+  bool freed = --swap_refs[slot] == 0;
+  if (freed) {
+    swap_owner[slot] = NULL;
+    bitmap_reset(swap_table, slot);
+  }
+  lock_release(&swap_lock);
+
+  if (freed) zswap_drop(slot);
+}
+
+/* Returns the number of pages referring to SLOT. */
+static unsigned swap_slot_refs(size_t slot) {
+  lock_acquire(&swap_lock);
+  unsigned refs = swap_refs[slot];
+  lock_release(&swap_lock);
+  return refs;
 }
 
 /* Initialize the file mapping */
@@ -53,51 +169,244 @@ bool anon_initializer(struct page *page, enum vm_type type, void *kva) {
   return true;
 }
 
-/* Swap in the page by read contents from the swap disk. */
+/* Returns the page that alone owns SLOT if it is a non-resident page of
+ * the current process whose copy is on disk, so it can be read in
+ * together with a neighbour. */
+static struct page *swap_cluster_page(size_t slot) {
+  struct page *page = NULL;
+
+  lock_acquire(&swap_lock);
+  if (slot < bitmap_size(swap_table) && swap_refs[slot] == 1) {
+    page = swap_owner[slot];
+  }
+  lock_release(&swap_lock);
+
+  if (page == NULL || page->owner != thread_current() ||
+      page->frame != NULL || page->anon.swap_slot != slot ||
+      zswap_holds(slot)) {
+    return NULL;
+  }
+  return page;
+}
+
+/* Swap in the page by read contents from the compressed pool or, if its
+ * copy is not there, from the swap disk.
+ * The following slots of the same cluster that still belong to this
+ * process are read by the same command into spare frames and mapped
+ * right away, so a sequential refault costs one I/O per cluster.
+ * The slots stay allocated as a swap cache: until a page is dirtied its
+ * swap copy remains valid and evicting it again needs no write, unless
+ * swap fills up and anon_reclaim_swap_cache() takes the slot back. */
 static bool anon_swap_in(struct page *page, void *kva) {
   struct anon_page *anon_page = &page->anon;
+  struct disk_seg segs[SWAP_CLUSTER];
+  struct page *pages[SWAP_CLUSTER];
+  struct frame *frames[SWAP_CLUSTER];
+  size_t cnt = 1;
 
   if (anon_page->swap_slot == BITMAP_ERROR) {
     memset(kva, 0, PGSIZE);
     return true;
   }
+  if (zswap_load(anon_page->swap_slot, kva)) return true;
+
+  segs[0].buffer = kva;
+  segs[0].cnt = SECTORS_PER_SLOT;
+  while (cnt < SWAP_CLUSTER) {
+    struct page *next = swap_cluster_page(anon_page->swap_slot + cnt);
+    if (next == NULL) break;
 
-  for (int i = 0; i < 8; i++) {
-    disk_read(swap_disk, (anon_page->swap_slot * 8) + i,
-              kva + DISK_SECTOR_SIZE * i);
+    struct frame *frame = vm_get_spare_frame();
+    if (frame == NULL) break;
+
+    pages[cnt] = next;
+    frames[cnt] = frame;
+    segs[cnt].buffer = frame->kva;
+    segs[cnt].cnt = SECTORS_PER_SLOT;
+    cnt++;
   }
 
-  bitmap_reset(swap_table, anon_page->swap_slot);
-  anon_page->swap_slot = BITMAP_ERROR;
+  disk_readv(swap_disk, anon_page->swap_slot * SECTORS_PER_SLOT, segs, cnt);
+
+  for (size_t i = 1; i < cnt; i++) {
+    vm_map_frame(pages[i], frames[i]);
+  }
   return true;
 }
 
-/* Swap out the page by writing contents to the swap disk. */
-static bool anon_swap_out(struct page *page) {
+/* Writes the frame at KVA to swap slot SLOT, compressed into the pool if
+ * it fits there. */
+static void swap_write(size_t slot, const void *kva) {
+  struct disk_seg seg = {(void *)kva, SECTORS_PER_SLOT};
+
+  if (zswap_store(slot, kva)) return;
+  disk_writev(swap_disk, slot * SECTORS_PER_SLOT, &seg, 1);
+}
+
+/* Returns the number of swap slots, 0 without a swap disk. */
+size_t anon_swap_slots(void) {
+  return swap_table != NULL ? bitmap_size(swap_table) : 0;
+}
+
+/* True if resident PAGE still holds a swap slot.  The copy there is up to
+ * date unless the page's dirty bit is set. */
+bool anon_has_swap_copy(struct page *page) {
+  return page->anon.swap_slot != BITMAP_ERROR;
+}
+
+/* Writes resident PAGE to swap without evicting it, so a later eviction
+ * finds it clean.  The dirty bit is cleared before the write, so a store
+ * racing with the I/O leaves the page dirty again.  A slot still shared
+ * with another process is never overwritten; PAGE gets a fresh one. */
+bool anon_writeback(struct page *page) {
   struct anon_page *anon_page = &page->anon;
+  size_t slot_idx = anon_page->swap_slot;
 
-  size_t slot_idx = bitmap_scan_and_flip(swap_table, 0, 1, false);
+  ASSERT(page->frame != NULL);
 
-  if (slot_idx == BITMAP_ERROR) {
-    PANIC("swap disk is full");
-  }
+  if (slot_idx != BITMAP_ERROR) {
+    if (!pml4_is_dirty(page->owner->pml4, page->va)) return true;
 
-  for (int i = 0; i < 8; i++) {
-    disk_write(swap_disk, (slot_idx * 8) + i,
-               page->frame->kva + DISK_SECTOR_SIZE * i);
+    // 낡은 사본: 혼자 쓰는 슬롯이면 그 자리에 다시 씀
+    swap_cache_stale++;
+    if (swap_slot_refs(slot_idx) > 1) {
+      swap_slot_put(slot_idx);
+      anon_page->swap_slot = slot_idx = BITMAP_ERROR;
+    }
+  }
+  if (slot_idx == BITMAP_ERROR) {
+    slot_idx = swap_slots_get(&page, 1);
+    if (slot_idx == BITMAP_ERROR) return false;
   }
 
+  pml4_set_dirty(page->owner->pml4, page->va, false);
+  swap_write(slot_idx, page->frame->kva);
   anon_page->swap_slot = slot_idx;
 
   return true;
 }
 
-/* Destroy the anonymous page. PAGE will be freed by the caller. */
-static void anon_destroy(struct page *page) {
-  /* 현재 단계에서 추가 리소스 없음 (swap 단계에서 메타/슬롯 정리 추가 예정)*/
+/* Writes the CNT resident PAGES to a run of contiguous swap slots, as
+ * anon_writeback() does for one page.  Pages that do not fit in the
+ * compressed pool go to disk, one command per run of adjacent slots.
+ * Each page's old slot is released.  Returns false, writing nothing, if
+ * no run of CNT free slots exists. */
+bool anon_writeback_cluster(struct page **pages, size_t cnt) {
+  struct disk_seg segs[SWAP_CLUSTER];
+  size_t run = 0;  // disk에 쓸 연속 슬롯 수
+
+  ASSERT(cnt <= SWAP_CLUSTER);
+
+  size_t slot = swap_slots_get(pages, cnt);
+  if (slot == BITMAP_ERROR) return false;
+
+  for (size_t i = 0; i < cnt; i++) {
+    struct page *page = pages[i];
+    ASSERT(page->frame != NULL);
+
+    anon_swap_unshare(page);
+    pml4_set_dirty(page->owner->pml4, page->va, false);
+    page->anon.swap_slot = slot + i;
+
+    if (zswap_store(slot + i, page->frame->kva)) {
+      // pool에 들어간 슬롯에서 disk 쓰기 run이 끊김
+      if (run > 0) {
+        disk_writev(swap_disk, (slot + i - run) * SECTORS_PER_SLOT, segs, run);
+      }
+      run = 0;
+      continue;
+    }
+    segs[run].buffer = page->frame->kva;
+    segs[run].cnt = SECTORS_PER_SLOT;
+    run++;
+  }
+  if (run > 0) {
+    disk_writev(swap_disk, (slot + cnt - run) * SECTORS_PER_SLOT, segs, run);
+  }
+  return true;
+}
+
+/* Makes DST refer to SRC's swap slot, dropping the one DST had.  Used when
+ * two pages share a frame and the frame was written back once. */
+void anon_swap_share(struct page *dst, struct page *src) {
+  if (dst->anon.swap_slot == src->anon.swap_slot) return;
+  anon_swap_unshare(dst);
+
+  // 회수와 겹치지 않도록 src의 슬롯은 swap_lock 안에서 읽음
+  lock_acquire(&swap_lock);
+  size_t slot = src->anon.swap_slot;
+  if (slot != BITMAP_ERROR) {
+    swap_refs[slot]++;
+    swap_owner[slot] = NULL;
+  }
+  dst->anon.swap_slot = slot;
+  lock_release(&swap_lock);
+}
+
+/* Drops PAGE's swap copy, which is about to diverge from its contents.
+ * The slot is taken under swap_lock, so a concurrent
+ * anon_reclaim_swap_cache() cannot free it a second time. */
+void anon_swap_unshare(struct page *page) {
+  lock_acquire(&swap_lock);
+  size_t slot = page->anon.swap_slot;
+  page->anon.swap_slot = BITMAP_ERROR;
+  lock_release(&swap_lock);
+
+  if (slot != BITMAP_ERROR) swap_slot_put(slot);
+}
+
+/* Sets up CHILD, a copy of PARENT made by fork(), to share PARENT's swap
+ * copy.  A copy that is stale because PARENT is resident and dirty is not
+ * shared. */
+void anon_fork(struct page *child, struct page *parent) {
+  size_t slot = parent->anon.swap_slot;
+
+  child->anon.swap_slot = BITMAP_ERROR;
+  if (slot == BITMAP_ERROR) return;
+  if (parent->frame != NULL &&
+      pml4_is_dirty(parent->owner->pml4, parent->va)) {
+    return;
+  }
+  anon_swap_share(child, parent);
+}
+
+/* Swap out the page by writing contents to the swap disk.
+ * Returns false if swap is full, which fails the eviction and with it the
+ * fault that needed a frame. */
+static bool anon_swap_out(struct page *page) {
   struct anon_page *anon_page = &page->anon;
 
-  if (anon_page->swap_slot != BITMAP_ERROR) {
-    bitmap_reset(swap_table, anon_page->swap_slot);
+  // 이미 swap에 최신 사본이 있으면 쓰기 생략
+  if (anon_page->swap_slot != BITMAP_ERROR &&
+      !pml4_is_dirty(page->owner->pml4, page->va)) {
+    swap_cache_hits++;
+    return true;
   }
+
+  return anon_writeback(page);
+}
+
+/* Destroy the anonymous page. PAGE will be freed by the caller. */
+static void anon_destroy(struct page *page) {
+  // 메모리에 올라와 있으면 매핑을 지우고 frame을 돌려줌.
+  // (매핑을 지워야 pml4_destroy가 같은 물리 페이지를 다시 해제하지 않음)
+  if (page->frame != NULL) {
+    pml4_clear_page(page->owner->pml4, page->va);
+    vm_frame_unlink(page);
+  } else {
+    // 공유 zero page가 매핑되어 있을 수 있음
+    pml4_clear_page(page->owner->pml4, page->va);
+  }
+
+  anon_swap_unshare(page);
+  vm_uncommit_pages(page->owner, 1);
+}
+
+/* Prints swap cache statistics. */
+void anon_print_stats(void) {
+  printf(
+      "Swap cache: %llu evictions without write, %llu stale copies, "
+      "%llu slots reclaimed\n",
+      swap_cache_hits, swap_cache_stale, swap_cache_reclaimed);
+  zswap_print_stats();
 }
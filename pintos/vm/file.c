@@ -6,7 +6,13 @@ static bool file_backed_swap_in(struct page *page, void *kva);
 static bool file_backed_swap_out(struct page *page);
 static void file_backed_destroy(struct page *page);
 
+#include <mman.h>
+#include <round.h>
+#include <string.h>
+
 #include "filesys/filesys.h"
+#include "filesys/inode.h"
+#include "threads/malloc.h"
 #include "threads/mmu.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
@@ -141,10 +147,10 @@ static bool file_backed_swap_in(struct page *page, void *kva) {
   return true;
 }
 
-/* Swap out the page by writeback contents to the file. */
-/* Swap out the page by writeback contents to the file. */
-/* Swap out the page by writeback contents to the file. */
-static bool file_backed_swap_out(struct page *page) {
+/* Writes resident PAGE back to its file if it is dirty, without evicting
+ * it.  The dirty bit is cleared before the write, so a store racing with
+ * the I/O leaves the page dirty again. */
+bool file_backed_writeback(struct page *page) {
   struct file_page *file_page = &page->file;
 
   if (file_page->file == NULL || page->frame == NULL) {
@@ -154,24 +160,34 @@ static bool file_backed_swap_out(struct page *page) {
   // dirty bit 확인 및 write back
   bool is_dirty = pml4_is_dirty(page->owner->pml4, page->va);
   if (is_dirty && file_page->read_bytes > 0) {
+    pml4_set_dirty(page->owner->pml4, page->va, false);
+
+#ifdef EFILESYS
+    // 페이지 캐시와 같은 frame이므로 filesys_lock 없이 디스크에 바로 기록
+    inode_write_page(file_get_inode(file_page->file), file_page->ofs,
+                     page->frame->kva, file_page->read_bytes);
+    return true;
+#endif
     lock_acquire(&filesys_lock);
     off_t bytes_written = file_write_at(file_page->file, page->frame->kva,
                                         file_page->read_bytes, file_page->ofs);
     lock_release(&filesys_lock);
     if (bytes_written != (off_t)file_page->read_bytes) {
+      pml4_set_dirty(page->owner->pml4, page->va, true);
       return false;
     }
-
-    // dirty bit 제거
-    pml4_set_dirty(page->owner->pml4, page->va, false);
   }
 
-  // swap_out의 역할은 여기까지!
-  // pml4_clear_page와 frame 연결 해제는 vm_evict_frame에서!
-
   return true;
 }
 
+/* Swap out the page by writeback contents to the file. */
+static bool file_backed_swap_out(struct page *page) {
+  // swap_out의 역할은 write back까지!
+  // pml4_clear_page와 frame 연결 해제는 vm_evict_frame에서!
+  return file_backed_writeback(page);
+}
+
 /* Destory the file backed page. PAGE will be freed by the caller. */
 // static void file_backed_destroy(struct page *page) {
 //   struct file_page *file_page UNUSED = &page->file;
@@ -188,25 +204,18 @@ static bool file_backed_swap_out(struct page *page) {
 
 static void file_backed_destroy(struct page *page) {
   struct file_page *file_page = &page->file;
-  struct thread *t = thread_current();
+  struct thread *t = page->owner;
 
   // frame이 있으면 (메모리에 로드되어 있으면)
   if (page->frame) {
-    // dirty한지 확인하고 write back
-    bool is_dirty = pml4_is_dirty(t->pml4, page->va);
-    if (is_dirty && file_page->read_bytes > 0) {
-      file_write_at(file_page->file, page->frame->kva, file_page->read_bytes,
-                    file_page->ofs);
-    }
+    // dirty면 write back
+    file_backed_writeback(page);
 
     // page table에서 매핑 제거
     pml4_clear_page(t->pml4, page->va);
 
-    // frame 해제
-    page->frame->page = NULL;
-    palloc_free_page(page->frame->kva);
-    free(page->frame);
-    page->frame = NULL;
+    // frame 연결 해제 (마지막 사용자면 frame table 슬롯은 재활용됨)
+    vm_frame_unlink(page);
   }
 
   // 파일 닫기
@@ -216,134 +225,175 @@ static void file_backed_destroy(struct page *page) {
   }
 }
 
-/* Lazy load function for mmap */
-static bool lazy_load_mmap(struct page *page, void *aux) {
-  struct file_page *file_info = (struct file_page *)aux;
-
-  // 파일에서 데이터 읽기
-  off_t bytes_read = file_read_at(file_info->file, page->frame->kva,
-                                  file_info->read_bytes, file_info->ofs);
+/* Returns the VMA of T that contains VA, or NULL. */
+struct vma *vma_find(struct thread *t, void *va) {
+  struct list_elem *e;
+  for (e = list_begin(&t->mmaps); e != list_end(&t->mmaps); e = list_next(e)) {
+    struct vma *vma = list_entry(e, struct vma, elem);
+    uint8_t *base = vma->base;
+    if ((uint8_t *)va >= base && (uint8_t *)va < base + vma->length) {
+      return vma;
+    }
+  }
+  return NULL;
+}
 
-  if (bytes_read < 0) {
-    return false;
+/* True if [START, END) overlaps a VMA or a page of T. */
+static bool vma_range_in_use(struct thread *t, uint8_t *start, uint8_t *end) {
+  struct list_elem *e;
+  for (e = list_begin(&t->mmaps); e != list_end(&t->mmaps); e = list_next(e)) {
+    struct vma *vma = list_entry(e, struct vma, elem);
+    uint8_t *base = vma->base;
+    if (start < base + vma->length && base < end) return true;
   }
 
-  // 나머지를 0으로 채우기
-  memset(page->frame->kva + bytes_read, 0, PGSIZE - bytes_read);
+  struct page *p = spt_find_next(&t->spt, start);
+  return p != NULL && (uint8_t *)p->va < end;
+}
 
-  return true;
+/* Creates the page of VMA that contains VA in the current process's SPT.
+ * Its contents are read from the file when it is claimed.  Returns the
+ * page, or NULL if out of memory. */
+struct page *vma_materialize(struct vma *vma, void *va) {
+  struct page *page = malloc(sizeof *page);
+  if (page == NULL) return NULL;
+
+  va = pg_round_down(va);
+  size_t ofs = (uint8_t *)va - (uint8_t *)vma->base;
+  size_t read_bytes = ofs < vma->read_bytes ? vma->read_bytes - ofs : 0;
+  if (read_bytes > PGSIZE) read_bytes = PGSIZE;
+
+  *page = (struct page){
+      .operations = &file_ops,
+      .va = va,
+      .vma = vma,
+      .writable = vma->writable,
+      .owner = thread_current(),
+      .file = (struct file_page){
+          .file = vma->file,
+          .ofs = vma->ofs + ofs,
+          .read_bytes = read_bytes,
+          .zero_bytes = PGSIZE - read_bytes,
+      }};
+
+  if (!spt_insert_page(&page->owner->spt, page)) {
+    free(page);
+    return NULL;
+  }
+  return page;
 }
 
-/* Do the mmap */
+/* Do the mmap.
+ * Only the VMA is recorded; its pages are created on first access, so
+ * the cost does not depend on LENGTH. */
 void *do_mmap(void *addr, size_t length, int writable, struct file *file,
               off_t offset) {
   ASSERT(addr != NULL);
   ASSERT(pg_ofs(addr) == 0);
   ASSERT(offset % PGSIZE == 0);
-  struct file *fp = file_reopen(file);
-  if (fp == NULL) {
+
+  struct thread *t = thread_current();
+  size_t map_len = ROUND_UP(length, PGSIZE);
+  if (vma_range_in_use(t, addr, (uint8_t *)addr + map_len)) {
     return NULL;
   }
-  uint8_t *start_addr = addr;
-  size_t total_page_count = (length + PGSIZE - 1) / PGSIZE;
-  off_t flen = file_length(fp);
-  size_t read_bytes = (flen < length) ? flen : length;
-  size_t zero_bytes = PGSIZE - (read_bytes % PGSIZE);
-  struct mmap_region *region = malloc(sizeof *region);
-  if (region == NULL) {
-    file_close(fp);
+
+  struct vma *vma = malloc(sizeof *vma);
+  if (vma == NULL) {
     return NULL;
   }
-  region->base = addr;
-  region->npages = total_page_count;
-  region->file = fp;  // :불: 버그 수정: file → fp
-  // :불: 디버그 5: 리스트 추가
-  list_push_back(&thread_current()->mmaps, &region->elem);
-  list_empty(&thread_current()->mmaps);
-  int page_idx = 0;
-  off_t current_offset = offset;
-  while (read_bytes > 0 || zero_bytes > 0) {
-    size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-    size_t page_zero_bytes = PGSIZE - page_read_bytes;
-    struct segment_aux *aux = malloc(sizeof *aux);
-    if (aux == NULL) {
-      file_close(fp);
-      goto rollback;
-    }
-    aux->file = fp;
-    aux->ofs = current_offset;  // :불: 버그 수정: offset → current_offset
-    aux->read_bytes = page_read_bytes;
-    aux->zero_bytes = page_zero_bytes;
-    aux->writable = writable;  // :불: 버그 수정: 추가!
-    if (!vm_alloc_page_with_initializer(VM_FILE, addr, writable, lazy_load_mmap,
-                                        aux)) {
-      free(aux);
-      goto rollback;
-    }
-    read_bytes -= page_read_bytes;
-    zero_bytes -= page_zero_bytes;
-    addr += PGSIZE;
-    current_offset += page_read_bytes;  // :불: 수정: offset을 증가시키지
-                                        // 말고 별도 변수 사용
-    page_idx++;
-  }
-  return start_addr;
-rollback:
-  for (size_t j = 0; j < total_page_count; j++) {
-    void *page_addr =
-        start_addr + (j * PGSIZE);  // :불: 버그 수정: addr → start_addr
-    struct page *page = spt_find_page(&thread_current()->spt, page_addr);
-    if (page != NULL) {
-      spt_remove_page(&thread_current()->spt, page);
-    }
+  vma->file = file_reopen(file);
+  if (vma->file == NULL) {
+    free(vma);
+    return NULL;
   }
-  list_remove(&region->elem);
-  free(region);
-  file_close(fp);  // :불: 추가: rollback 시 fp도 닫기
-  return NULL;
+
+  // 파일 끝을 넘는 부분은 0으로 채워진 페이지
+  off_t flen = file_length(vma->file);
+  size_t file_left = flen > offset ? (size_t)(flen - offset) : 0;
+
+  vma->base = addr;
+  vma->length = map_len;
+  vma->ofs = offset;
+  vma->read_bytes = file_left < length ? file_left : length;
+  vma->writable = writable;
+  list_push_back(&t->mmaps, &vma->elem);
+  return addr;
+}
+
+static struct vma *vma_find_base(struct thread *t, void *base) {
+  struct vma *vma = vma_find(t, base);
+  return vma != NULL && vma->base == base ? vma : NULL;
 }
 
-static struct mmap_region *mmap_find_region(struct thread *t, void *base) {
+/* Copies the VMAs of PARENT to the current thread on fork().
+ * Each VMA gets its own reopened file handle. */
+bool vma_fork(struct thread *parent) {
+  struct thread *t = thread_current();
   struct list_elem *e;
-  for (e = list_begin(&t->mmaps); e != list_end(&t->mmaps); e = list_next(e)) {
-    struct mmap_region *rg = list_entry(e, struct mmap_region, elem);
-    if (rg->base == base) {
-      return rg;
+  for (e = list_begin(&parent->mmaps); e != list_end(&parent->mmaps);
+       e = list_next(e)) {
+    struct vma *src = list_entry(e, struct vma, elem);
+    struct vma *vma = malloc(sizeof *vma);
+    if (vma == NULL) return false;
+
+    *vma = *src;
+    vma->file = file_reopen(src->file);
+    if (vma->file == NULL) {
+      free(vma);
+      return false;
     }
+    list_push_back(&t->mmaps, &vma->elem);
   }
-  return NULL;
+  return true;
 }
 
-/* Do the munmap */
+/* Writes back the dirty resident pages of [ADDR, ADDR + LENGTH), which
+ * must be mapped by VMAs of the current process, and clears their dirty
+ * bits.  FLAGS is MS_SYNC to wait for the writes or MS_ASYNC to leave
+ * them to the page-out daemon.  Non-resident pages are already clean.
+ * Returns 0 on success, -1 if part of the range is not mapped or a write
+ * failed. */
+int do_msync(void *addr, size_t length, int flags) {
+  struct thread *t = thread_current();
+  uint8_t *start = pg_round_down(addr);
+  uint8_t *end = (uint8_t *)addr + length;
+
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    if (vma_find(t, va) == NULL) return -1;
+  }
+
+  int result = 0;
+  struct page *p;
+  for (p = spt_find_next(&t->spt, start); p != NULL && (uint8_t *)p->va < end;
+       p = spt_find_next(&t->spt, p->va + PGSIZE)) {
+    if (p->vma == NULL || VM_TYPE(p->operations->type) != VM_FILE) continue;
+    if (!vm_sync_page(p, flags == MS_ASYNC)) result = -1;
+  }
+  return result;
+}
+
+/* Do the munmap.
+ * Removes every page created for the VMA, writing dirty ones back, and
+ * then the VMA itself. */
 void do_munmap(void *va) {
   struct thread *t = thread_current();
-  struct mmap_region *rg = mmap_find_region(t, va);
-  if (rg == NULL) {
+  struct vma *vma = vma_find_base(t, va);
+  if (vma == NULL) {
     return;
   }
-  uint8_t *up = (uint8_t *)rg->base;
-  for (size_t i = 0; i < rg->npages; i++, up += PGSIZE) {
-    struct page *p = spt_find_page(&t->spt, up);
-    if (p == NULL) {
-      continue;
-    }
 
-    if (VM_TYPE(page_get_type(p)) == VM_FILE && p->frame != NULL) {
-      bool dirty = pml4_is_dirty(t->pml4, p->va);
-      if (dirty) {
-        size_t n = p->file.read_bytes;
-        if (n > 0) {
-          off_t written =
-              file_write_at(rg->file, p->frame->kva, n, p->file.ofs);
-          pml4_set_dirty(t->pml4, p->va, false);
-        }
-      }
-      spt_remove_page(&t->spt, p);
-    }
+  uint8_t *end = (uint8_t *)vma->base + vma->length;
+  struct page *p, *next;
+  for (p = spt_find_next(&t->spt, vma->base);
+       p != NULL && (uint8_t *)p->va < end; p = next) {
+    next = spt_find_next(&t->spt, p->va + PGSIZE);
+    spt_remove_page(&t->spt, p);  // destroy에서 dirty면 write back
   }
-  if (file_should_close(rg->file)) {
-    file_close(rg->file);
+
+  if (file_should_close(vma->file)) {
+    file_close(vma->file);
   }
-  list_remove(&rg->elem);
-  free(rg);
-}
\ No newline at end of file
+  list_remove(&vma->elem);
+  free(vma);
+}
@@ -74,5 +74,8 @@ static void uninit_destroy(struct page *page) {
     uninit->aux = NULL;
   }
 
+  // anon 페이지로 만들어질 예정이었으면 예약 반환
+  if (VM_TYPE(uninit->type) == VM_ANON) vm_uncommit_pages(page->owner, 1);
+
   return;
 }
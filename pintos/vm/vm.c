@@ -2,7 +2,14 @@
 
 #include "vm/vm.h"
 
+#include <round.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "devices/timer.h"
+#include "filesys/cache.h"
 #include "filesys/filesys.h"
+#include "intrinsic.h"
 #include "threads/malloc.h"
 #include "threads/vaddr.h"
 #include "userprog/process.h"
@@ -10,11 +17,161 @@
 #include "vm/file.h"
 #include "vm/inspect.h"
 
-// 프레임테이블, 카운트와 인덱스 전역 선언
-#define FRAME_TABLE_SIZE 6144
-static struct frame *frame_table[FRAME_TABLE_SIZE];
-static size_t frame_count = 0;
-static size_t clock_hand = 0;
+/* Frame table.  One descriptor per user-pool page, indexed by the
+ * page's position in the pool, so kva -> frame lookup is O(1).  The size is
+ * taken from the user pool that palloc_init() discovered at boot. */
+static struct frame *frame_table;
+static size_t frame_cnt;    // user pool 페이지 수 = frame_table 원소 수
+static uint8_t *frame_base; // user pool 첫 페이지의 kva
+static struct lock frame_lock;
+static struct condition frame_io_done; // frame의 eviction I/O가 끝남
+static size_t frame_capacity; // 실제로 사용 가능한 user pool 페이지 수
+static size_t frame_used;     // 현재 할당된 frame 수
+
+/* Page replacement policy, chosen with -rp= on the kernel command line. */
+enum vm_replace_policy vm_replace_policy = VM_RP_CLOCK_PRO;
+enum vm_load_policy vm_load_policy = VM_LOAD_LAZY;
+
+/* Replacement state, protected by frame_lock.
+ * CLOCK_PRO: resident frames are either hot (working set) or cold.  A cold
+ * frame that is referenced once enters its test period; referenced again in
+ * that period it is promoted to hot.  HAND_COLD picks victims among cold
+ * frames only, HAND_HOT demotes unreferenced hot frames and ends stale test
+ * periods, so one-shot streaming pages never push out the hot set. */
+static size_t hand_cold = 0;  // CLOCK에서는 유일한 hand
+static size_t hand_hot = 0;
+static size_t hot_cnt;        // hot 상태인 frame 수
+static size_t cold_target;    // cold 영역 목표 크기 (적응형)
+
+/* Non-resident test pages.  When a cold frame is evicted during its test
+ * period we stamp a hash slot of (owner, va) with the eviction clock; a
+ * refault within one memory's worth of evictions means the page would have
+ * been hot, so it comes back hot and the cold area grows. */
+static uint32_t *nonres_stamp;
+static uint32_t evict_clock;
+
+/* 한 hand가 victim을 찾으며 도는 최대 거리. 무한 루프 방지 */
+#define SCAN_LIMIT (2 * frame_cnt)
+
+/* 한 번의 eviction에서 모아서 write back 하는 dirty 후보 최대 수 */
+#define EVICT_BATCH 8
+
+/* 모은 후보를 write back 해도 victim이 나오지 않을 때 다시 시도하는 횟수 */
+#define EVICT_ROUNDS 3
+
+/* 한 hand가 지나간 frame 수 누계 (통계용) */
+static uint64_t scan_cnt;
+
+/* Resident set sharing.  Before a global eviction, each process holding
+ * frames is given an equal share of the user pool.  If anyone is over
+ * its share, frames whose processes are all within their share (and
+ * their setrss() limit) are passed over while another unreferenced frame
+ * can be found, so one process streaming through memory cannot push out
+ * everybody else's working set.  A process over its own limit replaces
+ * its own pages instead of taking new frames. */
+static size_t rss_share;       // 0이면 보호하지 않음
+static uint64_t rss_local_evictions;
+
+/* Page-out daemon.  Woken when free frames drop below the low watermark,
+ * it evicts until the high watermark is reached.  0 means "pick a
+ * default from the pool size" at vm_init() time. */
+size_t vm_low_watermark;
+size_t vm_high_watermark;
+static struct semaphore pageout_wakeup;
+static bool pageout_pending;
+static uint64_t pageout_wakeups;
+static uint64_t pageout_scanned;
+static uint64_t pageout_reclaimed;
+
+/* Frames whose write-back msync(MS_ASYNC) left to the page-out daemon,
+ * and pages written back on behalf of msync(). */
+static size_t flush_cnt;
+static uint64_t sync_writebacks;
+static uint64_t async_writebacks;
+
+/* Fault-around.  A fault on a lazy file-backed page also populates the
+ * neighbouring lazy pages of the same file within an aligned window of
+ * this many pages, using spare frames only.  1 disables it. */
+size_t vm_fault_around = 8;
+static uint64_t fault_around_pages;
+
+/* Exec-time prefault.  Under the eager and hybrid load policies, exec()
+ * maps pages of the executable before the program starts, reading each
+ * run of up to PREFAULT_BATCH contiguous pages with one file_read_at()
+ * through a bounce buffer.  Only spare frames are used, so it never
+ * evicts. */
+#define PREFAULT_BATCH 16
+static uint64_t prefault_pages;
+static uint64_t prefault_reads;
+
+/* Page index.  A frame read from a file for a file-backed page is
+ * published under (inode, offset), so that a later fault on the same
+ * bytes, from any process, maps the resident frame instead of reading
+ * another copy.  A published user frame is mapped read-only everywhere:
+ * the first write leaves the index or copies the frame in vm_handle_wp(),
+ * so an indexed frame always holds what was read.  frame_forget() drops
+ * the entry when the frame leaves memory, vm_file_written() when write()
+ * makes it stale.  Protected by frame_lock. */
+static struct hash page_index;
+static uint64_t page_index_hits;
+
+/* The shared zero page.  A read fault on an anonymous page that has
+ * never been written maps this kernel page read-only instead of a frame
+ * of zeros; the first write gives the page a frame of its own through
+ * vm_handle_wp().  It is not in the frame table and is never evicted. */
+static void *zero_page;
+static uint64_t zero_page_maps;
+
+/* Same-page merging.  With -ksm=PAGES the ksmd thread checksums up to
+ * PAGES frames of anonymous memory per pass.  A frame whose checksum has
+ * not changed since the previous pass is stable, and is compared with
+ * the last stable frame seen with the same checksum; if the two are
+ * identical, its pages are moved onto the other frame copy-on-write and
+ * it is freed.  A write to a merged page breaks the share in
+ * vm_handle_wp() as after fork(). */
+size_t vm_ksm_pages;
+#define KSM_SLEEP 25             /* Timer ticks between passes. */
+static struct frame **ksm_slots; // checksum으로 찾는 안정된 frame 후보
+static size_t ksm_hand;
+static uint64_t ksm_scanned;
+static uint64_t ksm_merged;
+
+/* Anonymous memory accounting.  Every anonymous page is charged to its
+ * process when it is created, whether or not it is ever touched, and the
+ * total may not exceed commit_limit, the pages that swap plus the user
+ * pool can back.  A process that asks for more fails cleanly (exec, stack
+ * growth, fork) instead of filling swap and bringing the kernel down at
+ * eviction time.  Slots a resident page keeps as a swap cache do not
+ * shrink the limit: anon_reclaim_swap_cache() takes them back when an
+ * evicted page needs one. */
+static size_t commit_limit;
+static size_t committed;
+static uint64_t commit_refused;
+
+/* Fault and eviction statistics of the whole system.  Per-process ones
+ * live in struct thread.  Both are updated with interrupts off, since
+ * evictions charge pages of other processes. */
+static struct vmstat vm_stats;
+
+/* How a page fault was resolved, for statistics. */
+enum vm_fault_kind {
+  FAULT_MINOR,  /* No I/O. */
+  FAULT_STACK,  /* Stack growth. */
+  FAULT_ELF,    /* Lazy executable page. */
+  FAULT_MMAP,   /* Page read from a mapped file. */
+  FAULT_SWAPIN, /* Anonymous page read from swap. */
+  FAULT_WP,     /* Copy-on-write. */
+};
+
+static void frame_table_init(void);
+static hash_hash_func page_index_hash;
+static hash_less_func page_index_less;
+static void frame_forget(struct frame *frame);
+static void frame_unpublish(struct frame *frame);
+static void frame_publish(struct frame *frame, struct page *page);
+static void pageout_init(void);
+static void pageout_daemon(void *aux);
+static void ksm_init(void);
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
  * intialize codes. */
@@ -27,6 +184,287 @@ void vm_init(void) {
   register_inspect_intr();
   /* DO NOT MODIFY UPPER LINES. */
   /* TODO: Your code goes here. */
+  frame_table_init();
+  pageout_init();
+  zero_page = palloc_get_page(PAL_ASSERT | PAL_ZERO);
+  commit_limit = frame_capacity + anon_swap_slots();
+  if (vm_ksm_pages > 0) ksm_init();
+}
+
+/* Allocates the frame table, one entry per page of the user pool. */
+static void frame_table_init(void) {
+  frame_base = palloc_user_pool_base(&frame_cnt);
+  frame_table = calloc(frame_cnt, sizeof *frame_table);
+  if (frame_table == NULL) {
+    PANIC("frame table allocation failed (%zu frames)", frame_cnt);
+  }
+
+  for (size_t i = 0; i < frame_cnt; i++) {
+    frame_table[i].kva = frame_base + i * PGSIZE;
+    list_init(&frame_table[i].pages);
+  }
+  lock_init(&frame_lock);
+  cond_init(&frame_io_done);
+  frame_capacity = palloc_user_free_cnt();
+  if (!hash_init(&page_index, page_index_hash, page_index_less, NULL)) {
+    PANIC("page index allocation failed");
+  }
+
+  nonres_stamp = calloc(frame_cnt, sizeof *nonres_stamp);
+  if (nonres_stamp == NULL) {
+    PANIC("non-resident table allocation failed");
+  }
+  cold_target = frame_cnt / 4 + 1;
+}
+
+/* Selects the page replacement policy by NAME ("clock" or "clock-pro").
+ * Returns false if NAME is unknown. */
+bool vm_set_replace_policy(const char *name) {
+  if (!strcmp(name, "clock")) {
+    vm_replace_policy = VM_RP_CLOCK;
+  } else if (!strcmp(name, "clock-pro")) {
+    vm_replace_policy = VM_RP_CLOCK_PRO;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/* Selects the executable load policy by NAME ("lazy", "eager" or
+ * "hybrid").  Returns false if NAME is unknown. */
+bool vm_set_load_policy(const char *name) {
+  if (!strcmp(name, "lazy")) {
+    vm_load_policy = VM_LOAD_LAZY;
+  } else if (!strcmp(name, "eager")) {
+    vm_load_policy = VM_LOAD_EAGER;
+  } else if (!strcmp(name, "hybrid")) {
+    vm_load_policy = VM_LOAD_HYBRID;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/* Sets the fault-around window to PAGES, clamped to 1..VM_FAULT_AROUND_MAX. */
+void vm_set_fault_around(size_t pages) {
+  if (pages < 1) pages = 1;
+  if (pages > VM_FAULT_AROUND_MAX) pages = VM_FAULT_AROUND_MAX;
+  vm_fault_around = pages;
+}
+
+/* Returns the counter of ST for faults of KIND. */
+static uint64_t *vmstat_fault_counter(struct vmstat *st,
+                                      enum vm_fault_kind kind) {
+  switch (kind) {
+    case FAULT_STACK:
+      return &st->stack_faults;
+    case FAULT_ELF:
+      return &st->elf_faults;
+    case FAULT_MMAP:
+      return &st->mmap_faults;
+    case FAULT_SWAPIN:
+      return &st->swapin_faults;
+    case FAULT_WP:
+      return &st->wp_faults;
+    case FAULT_MINOR:
+    default:
+      return &st->minor_faults;
+  }
+}
+
+/* Records a fault of KIND that took CYCLES, for the current process and
+ * globally. */
+static void vmstat_fault(enum vm_fault_kind kind, uint64_t cycles) {
+  struct vmstat *mine = &thread_current()->vmstat;
+  size_t bucket = 0;
+
+  while (bucket < VMSTAT_HIST_BUCKETS - 1 && cycles >> (bucket + 1) != 0) {
+    bucket++;
+  }
+
+  enum intr_level old_level = intr_disable();
+  (*vmstat_fault_counter(mine, kind))++;
+  (*vmstat_fault_counter(&vm_stats, kind))++;
+  mine->exec_faults++;
+  mine->latency[bucket]++;
+  vm_stats.latency[bucket]++;
+  intr_set_level(old_level);
+}
+
+/* Records the eviction of PAGE. */
+static void vmstat_evict(struct page *page, bool dirty) {
+  struct vmstat *owner = &page->owner->vmstat;
+
+  enum intr_level old_level = intr_disable();
+  if (dirty) {
+    owner->dirty_evictions++;
+    vm_stats.dirty_evictions++;
+  } else {
+    owner->clean_evictions++;
+    vm_stats.clean_evictions++;
+  }
+  intr_set_level(old_level);
+}
+
+/* Records CNT pages written back to their backing store. */
+static void vmstat_writeback(size_t cnt) {
+  enum intr_level old_level = intr_disable();
+  vm_stats.writebacks += cnt;
+  intr_set_level(old_level);
+}
+
+/* Copies the statistics of SCOPE, VMSTAT_PROCESS or VMSTAT_GLOBAL, to ST. */
+void vm_get_stats(int scope, struct vmstat *st) {
+  struct thread *t = thread_current();
+
+  enum intr_level old_level = intr_disable();
+  if (scope == VMSTAT_GLOBAL) {
+    *st = vm_stats;
+    st->rss = frame_used;
+    st->rss_limit = frame_capacity;
+    st->pageout_evictions = pageout_reclaimed;
+    st->ksm_merged = ksm_merged;
+    cache_get_stats(&st->cache_hits, &st->cache_misses, &st->readahead_hits);
+#ifdef EFILESYS
+    page_cache_get_stats(&st->cache_hits, &st->cache_misses,
+                         &st->readahead_hits);
+#endif
+  } else {
+    *st = t->vmstat;
+    st->rss = t->rss;
+    st->rss_limit = t->rss_limit;
+  }
+  intr_set_level(old_level);
+}
+
+/* Returns the frame descriptor of user-pool page KVA. */
+struct frame *vm_kva_to_frame(void *kva) {
+  ASSERT(pg_ofs(kva) == 0);
+  ASSERT((uint8_t *)kva >= frame_base);
+
+  size_t idx = ((uint8_t *)kva - frame_base) / PGSIZE;
+  ASSERT(idx < frame_cnt);
+  return &frame_table[idx];
+}
+
+/* Returns the first page mapping FRAME, or NULL if FRAME is free. */
+static struct page *frame_page(struct frame *frame) {
+  if (list_empty(&frame->pages)) return NULL;
+  return list_entry(list_front(&frame->pages), struct page, frame_elem);
+}
+
+/* Links PAGE to FRAME and charges it to its process's resident set.
+ * Must be called with frame_lock held. */
+static void frame_link(struct frame *frame, struct page *page) {
+  list_push_back(&frame->pages, &page->frame_elem);
+  page->frame = frame;
+  page->owner->rss++;
+}
+
+/* Undoes frame_link().  Must be called with frame_lock held. */
+static void frame_unlink(struct page *page) {
+  list_remove(&page->frame_elem);
+  page->frame = NULL;
+  page->owner->rss--;
+}
+
+/* Marks FRAME as being written back by an evictor, which does the I/O
+ * without frame_lock.  The frame is pinned meanwhile, and its list of
+ * pages must not change: code that would link or unlink a page waits in
+ * frame_io_wait() first.  Must be called with frame_lock held. */
+static void frame_io_begin(struct frame *frame) {
+  ASSERT(!frame->io);
+  frame->io = true;
+  frame->pin_cnt++;
+}
+
+/* Ends the write-back started by frame_io_begin().  The caller wakes the
+ * waiters with cond_broadcast() on frame_io_done.  Must be called with
+ * frame_lock held. */
+static void frame_io_end(struct frame *frame) {
+  ASSERT(frame->io);
+  frame->io = false;
+  frame->pin_cnt--;
+}
+
+/* Waits while PAGE's frame is being written back, then returns it, which
+ * may be NULL if the write-back was followed by eviction.  Must be called
+ * with frame_lock held. */
+static struct frame *frame_io_wait(struct page *page) {
+  while (page->frame != NULL && page->frame->io) {
+    cond_wait(&frame_io_done, &frame_lock);
+  }
+  return page->frame;
+}
+
+/* Unlinks PAGE from its frame.  When the last page goes away the frame
+ * returns to the user pool, so the slot can be handed out again by
+ * vm_get_frame().  The caller must already have removed PAGE's mapping. */
+void vm_frame_unlink(struct page *page) {
+  ASSERT(page->frame != NULL);
+
+  lock_acquire(&frame_lock);
+  struct frame *frame = frame_io_wait(page);
+  ASSERT(frame != NULL);
+  frame_unlink(page);
+  if (list_empty(&frame->pages)) {
+    frame->pin_cnt = 0;
+    frame_forget(frame);
+    palloc_free_page(frame->kva);
+    frame_used--;
+  }
+  lock_release(&frame_lock);
+}
+
+/* Makes DST, a page of the current process, share SRC's frame
+ * copy-on-write if SRC is resident.  Both mappings become read-only; the
+ * first write to either of them is resolved by vm_handle_wp().  SRC is
+ * looked at under frame_lock, so if it was just evicted DST is simply
+ * left without a frame.  Returns false only if the mapping cannot be
+ * installed. */
+bool vm_frame_share(struct page *src, struct page *dst) {
+  bool success = true;
+
+  lock_acquire(&frame_lock);
+  struct frame *frame = frame_io_wait(src);
+  if (frame != NULL) {
+    if (pml4_set_page(dst->owner->pml4, dst->va, frame->kva, false)) {
+      pml4_set_writable(src->owner->pml4, src->va, false);
+      frame_link(frame, dst);
+    } else {
+      success = false;
+    }
+  }
+  lock_release(&frame_lock);
+  return success;
+}
+
+/* Pins PAGE's frame so that it is not evicted, and returns it.  Returns
+ * NULL if PAGE is not resident. */
+struct frame *vm_frame_pin(struct page *page) {
+  lock_acquire(&frame_lock);
+  struct frame *frame = page->frame;
+  if (frame != NULL) frame->pin_cnt++;
+  lock_release(&frame_lock);
+  return frame;
+}
+
+/* Drops a pin taken by vm_frame_pin(). */
+void vm_frame_unpin(struct frame *frame) {
+  lock_acquire(&frame_lock);
+  ASSERT(frame->pin_cnt > 0);
+  frame->pin_cnt--;
+  lock_release(&frame_lock);
+}
+
+/* Frees the swap-cache slots of resident anon pages when swap is full.
+ * frame_lock keeps evictors from relying on a copy while it goes away.
+ * Returns the number of slots freed. */
+size_t vm_reclaim_swap_cache(void) {
+  lock_acquire(&frame_lock);
+  size_t freed = anon_reclaim_swap_cache();
+  lock_release(&frame_lock);
+  return freed;
 }
 
 /* Get the type of the page. This function is useful if you want to know the
@@ -43,9 +481,13 @@ enum vm_type page_get_type(struct page *page) {
 }
 
 /* Helpers */
-static struct frame *vm_get_victim(void);
+static struct frame *vm_get_victim(struct thread *owner);
 static bool vm_do_claim_page(struct page *page);
-static struct frame *vm_evict_frame(void);
+static bool vm_install_page(struct page *page, struct frame *frame);
+static bool vm_handle_fault(struct intr_frame *f, void *addr, bool user,
+                            bool write, bool not_present,
+                            enum vm_fault_kind *kind);
+static struct frame *vm_evict_frame(struct thread *owner);
 
 /* Create the pending page object with initializer. If you want to create a
  * page, do not create it directly and make it through this function or
@@ -83,6 +525,13 @@ bool vm_alloc_page_with_initializer(enum vm_type type, void *upage,
         goto err;
     }
 
+    // anon 페이지는 swap/RAM을 미리 예약. 해제는 destroy에서
+    if (initializer == anon_initializer &&
+        !vm_commit_pages(thread_current(), 1)) {
+      free(page);
+      goto err;
+    }
+
     // page 초기화
     uninit_new(page, upage, init, type, aux, initializer);
 
@@ -101,33 +550,111 @@ err:
   return false;
 }
 
-/* Hash Table Helpers */
-static unsigned page_hash(const struct hash_elem *e, void *aux UNUSED) {
-  const struct page *p = hash_entry(e, struct page, hash_elem);
-  return hash_bytes(&p->va, sizeof p->va);
+/* Reserves CNT anonymous pages for T.  Returns false, reserving nothing,
+ * if that would commit more memory than swap and RAM can back. */
+bool vm_commit_pages(struct thread *t, size_t cnt) {
+  bool success = false;
+
+  enum intr_level old_level = intr_disable();
+  if (cnt <= commit_limit - committed) {
+    committed += cnt;
+    t->vm_committed += cnt;
+    success = true;
+  } else {
+    commit_refused++;
+  }
+  intr_set_level(old_level);
+  return success;
+}
+
+/* Releases CNT anonymous pages reserved by T. */
+void vm_uncommit_pages(struct thread *t, size_t cnt) {
+  enum intr_level old_level = intr_disable();
+  ASSERT(committed >= cnt && t->vm_committed >= cnt);
+  committed -= cnt;
+  t->vm_committed -= cnt;
+  intr_set_level(old_level);
 }
 
-static bool page_less(const struct hash_elem *a, const struct hash_elem *b,
-                      void *aux UNUSED) {
-  const struct page *pa = hash_entry(a, struct page, hash_elem);
-  const struct page *pb = hash_entry(b, struct page, hash_elem);
-  return pa->va < pb->va;
+/* Supplemental page table.
+ * A radix tree keyed by virtual page number, shaped like the pml4: four
+ * levels of SPT_FANOUT-entry nodes, each node one kernel page.  A lookup
+ * is four array indexings, and walking the tree in index order visits
+ * pages in address order while skipping empty subtrees. */
+#define SPT_LEVELS 4
+#define SPT_FANOUT (PGSIZE / sizeof(void *))
+
+static const unsigned spt_shift[SPT_LEVELS] = {PML4SHIFT, PDPESHIFT,
+                                               PDXSHIFT, PTXSHIFT};
+
+static size_t spt_index(uint64_t va, int level) {
+  return (va >> spt_shift[level]) & (SPT_FANOUT - 1);
+}
+
+/* Returns the leaf slot for VA in SPT.  If CREATE, missing nodes are
+ * allocated; otherwise, or if allocation fails, returns NULL. */
+static struct page **spt_slot(struct supplemental_page_table *spt, void *va,
+                              bool create) {
+  void **slot = (void **)&spt->root;
+
+  for (int level = 0; level < SPT_LEVELS; level++) {
+    if (*slot == NULL) {
+      if (!create) return NULL;
+      *slot = palloc_get_page(PAL_ZERO);
+      if (*slot == NULL) return NULL;
+    }
+    slot = (void **)*slot + spt_index((uint64_t)va, level);
+  }
+  return (struct page **)slot;
+}
+
+/* Returns the lowest-addressed page at or above VA in NODE, a node at
+ * LEVEL, or NULL. */
+static struct page *spt_next_in(void **node, int level, uint64_t va) {
+  for (size_t i = spt_index(va, level); i < SPT_FANOUT; i++) {
+    if (node[i] != NULL) {
+      if (level == SPT_LEVELS - 1) return node[i];
+
+      struct page *page = spt_next_in(node[i], level + 1, va);
+      if (page != NULL) return page;
+    }
+    // 다음 자식부터는 처음부터 탐색
+    va = 0;
+  }
+  return NULL;
+}
+
+/* Frees NODE at LEVEL and every node below it. */
+static void spt_free_node(void **node, int level) {
+  if (level < SPT_LEVELS - 1) {
+    for (size_t i = 0; i < SPT_FANOUT; i++) {
+      if (node[i] != NULL) spt_free_node(node[i], level + 1);
+    }
+  }
+  palloc_free_page(node);
 }
 
 /* Find VA from spt and return page. On error, return NULL. */
 struct page *spt_find_page(struct supplemental_page_table *spt, void *va) {
   ASSERT(spt != NULL);
 
-  struct page *page = NULL;
+  if (!is_user_vaddr(va)) return NULL;
 
-  void *key = pg_round_down(va);
-  struct page temp = {.va = key};
-  struct hash_elem *e = hash_find(&spt->page_map, &temp.hash_elem);
+  struct page **slot = spt_slot(spt, pg_round_down(va), false);
+  return slot != NULL ? *slot : NULL;
+}
 
-  if (e != NULL) {
-    page = hash_entry(e, struct page, hash_elem);
-  }
-  return page;
+/* Returns the page of SPT with the lowest address at or above VA, or NULL.
+ * Pages can be visited in address order with
+ *   for (p = spt_find_next(spt, start); p != NULL && p->va < end;
+ *        p = spt_find_next(spt, p->va + PGSIZE))
+ * which stays valid if the visited page is removed, as long as its address
+ * is saved first. */
+struct page *spt_find_next(struct supplemental_page_table *spt, void *va) {
+  ASSERT(spt != NULL);
+
+  if (spt->root == NULL || !is_user_vaddr(va)) return NULL;
+  return spt_next_in(spt->root, 0, (uint64_t)pg_round_up(va));
 }
 
 /* Insert PAGE into spt with validation. */
@@ -139,299 +666,1646 @@ bool spt_insert_page(struct supplemental_page_table *spt, struct page *page) {
   // 같은 주소에 대해 중복 삽입이 발생하는 상황에 현재는 조용한 실패. ASSERT가
   // 필요한가?
 
-  bool succ = false;
-  struct hash_elem *prev = hash_insert(&spt->page_map, &page->hash_elem);
-  if (prev == NULL) {
-    succ = true;
-  }
+  struct page **slot = spt_slot(spt, page->va, true);
+  if (slot == NULL || *slot != NULL) return false;
 
-  return succ;
+  *slot = page;
+  return true;
 }
 
 void spt_remove_page(struct supplemental_page_table *spt, struct page *page) {
   ASSERT(spt && page);
-  hash_delete(&spt->page_map, &page->hash_elem);
+
+  struct page **slot = spt_slot(spt, page->va, false);
+  ASSERT(slot != NULL && *slot == page);
+  *slot = NULL;
   vm_dealloc_page(page);
   return;
 }
 
-/* Get the struct frame, that will be evicted. */
-static struct frame *vm_get_victim(void) {
-  while (true) {
-    struct frame *victim = frame_table[clock_hand];
+/* Replacement policy helpers.  All of them run with frame_lock held. */
 
-    // page 설정 시까지 시간차 존재, 혹시 모를 예외처리
-    ASSERT(victim != NULL);
-    ASSERT(victim->page != NULL);
+/* Test-and-clear of the accessed bits of every mapping of FRAME. */
+static bool frame_referenced(struct frame *frame) {
+  bool referenced = false;
+  struct list_elem *e;
 
-    // accessed bit 확인하고 1이면 0으로 변경
-    if (pml4_is_accessed(victim->page->owner->pml4, victim->page->va)) {
-      pml4_set_accessed(victim->page->owner->pml4, victim->page->va, false);
-    } else {
-      return victim;
+  for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, frame_elem);
+    if (pml4_is_accessed(page->owner->pml4, page->va)) {
+      pml4_set_accessed(page->owner->pml4, page->va, false);
+      referenced = true;
     }
-
-    clock_hand = (clock_hand + 1) % frame_count;
   }
+  return referenced;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
-static struct frame *vm_evict_frame(void) {
-  struct frame *victim = vm_get_victim();
-
-  // 스왑 아웃
-  swap_out(victim->page);
-
-  // 페이지 테이블 매핑 제거
-  pml4_clear_page(victim->page->owner->pml4, victim->page->va);
-
-  // 연결 끊기
-  victim->page->frame = NULL;
-  victim->page = NULL;
-
-  // frame은 빈 상태로, 재활용 가능
-  return victim;
+/* True if FRAME holds a page that may be evicted right now. */
+static bool frame_evictable(struct frame *frame) {
+  return !list_empty(&frame->pages) && frame->pin_cnt == 0;
 }
 
-/* palloc() and get frame. If there is no available page, evict the page
- * and return it. This always return valid address. That is, if the user pool
- * memory is full, this function evicts the frame to get the available memory
- * space.*/
-static struct frame *vm_get_frame(void) {
-  void *kva = palloc_get_page(PAL_USER);
+static size_t nonres_slot(struct page *page) {
+  uint64_t key = (uint64_t)page->owner ^ ((uint64_t)page->va >> PGBITS);
+  return (key * 0x9E3779B97F4A7C15ULL >> 32) % frame_cnt;
+}
 
-  if (kva == NULL) {
-    return vm_evict_frame();
+/* Drops FRAME's replacement state and page index entry when its page
+ * leaves memory. */
+static void frame_forget(struct frame *frame) {
+  if (frame->hot) hot_cnt--;
+  frame->hot = false;
+  frame->test = false;
+  frame->ksm_sum = 0;
+  if (frame->flush) {
+    frame->flush = false;
+    flush_cnt--;
   }
+  frame_unpublish(frame);
+}
 
-  struct frame *frame = malloc(sizeof(struct frame));
-  if (frame == NULL) {
-    palloc_free_page(kva);
-    return NULL;
+/* Runs HAND_HOT until the hot area fits in what cold_target leaves. */
+static void hand_hot_run(void) {
+  size_t hot_limit = frame_cnt - cold_target;
+
+  for (size_t n = 0; hot_cnt > hot_limit && n < SCAN_LIMIT; n++) {
+    struct frame *f = &frame_table[hand_hot];
+    hand_hot = (hand_hot + 1) % frame_cnt;
+    scan_cnt++;
+    if (!frame_evictable(f)) continue;
+
+    bool ref = frame_referenced(f);
+    if (f->hot) {
+      // 참조되지 않은 hot frame은 cold로 강등
+      if (!ref) {
+        f->hot = false;
+        hot_cnt--;
+      }
+    } else if (f->test && !ref) {
+      // 테스트 기간 동안 재참조가 없었음 → cold 영역을 줄임
+      f->test = false;
+      if (cold_target > 1) cold_target--;
+    }
   }
-
-  frame->kva = kva;
-  frame->page = NULL;
-
-  ASSERT(frame_count < FRAME_TABLE_SIZE);
-  frame_table[frame_count++] = frame;
-
-  return frame;
 }
 
-/* 스택 주소인지 체크 */
-bool is_stack_addr(void *addr, void *rsp) {
-  // 잘못된 주소(NULL, 커널 가상 주소) 접근
-  if (!addr || !is_user_vaddr(addr)) return false;
+/* True if T is over its resident set limit. */
+static bool rss_over_limit(struct thread *t) {
+  return t->rss_limit != 0 && t->rss >= t->rss_limit;
+}
 
-  // 유저 스택 주소가 아닌 경우
-  if (addr >= USER_STACK) return false;
+/* Recomputes rss_share for the next global eviction: the user pool
+ * divided among processes with resident pages, or 0 if nobody is over
+ * that share. */
+static void rss_share_update(void) {
+  size_t procs = 0, max_rss = 0;
+  struct list_elem *e;
+
+  enum intr_level old_level = intr_disable();
+  for (e = list_begin(&all_list); e != list_end(&all_list); e = list_next(e)) {
+    struct thread *t = list_entry(e, struct thread, all_elem);
+    if (t->rss == 0) continue;
+    procs++;
+    if (t->rss > max_rss) max_rss = t->rss;
+  }
+  intr_set_level(old_level);
 
-  // 유저 스택 범위를 넘어간 경우(스택 오버 플로우)
-  if (pg_round_down(addr) < USER_STACK - MAX_STACK_SIZE) return false;
+  rss_share = procs > 1 ? frame_capacity / procs : 0;
+  if (max_rss <= rss_share) rss_share = 0;
+}
 
-  // x86-64, PUSH 명령어에 의한 경우를 제외하고 스택 포인터를 벗어난 접근
-  if (addr < rsp - 8) return false;
+/* True if every process mapping FRAME is within its share and limit. */
+static bool frame_protected(struct frame *frame) {
+  struct list_elem *e;
 
+  if (rss_share == 0) return false;
+  for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+       e = list_next(e)) {
+    struct thread *t = list_entry(e, struct page, frame_elem)->owner;
+    if (t->rss > rss_share || rss_over_limit(t)) return false;
+  }
   return true;
 }
 
-/* Growing the stack. */
-static void vm_stack_growth(void *addr UNUSED) {
-  void *upage = pg_round_down(addr);
-
-  vm_alloc_page(VM_ANON | VM_MARKER_0, upage, true);
+/* Plain second-chance clock.  Gives up after SCAN_LIMIT steps and takes
+ * the first evictable frame it saw, so it cannot spin forever when every
+ * page keeps getting referenced. */
+static struct frame *clock_get_victim(void) {
+  struct frame *fallback = NULL;
+  struct frame *spare = NULL;  // 몫 안의 프로세스 frame. 다른 후보가 없을 때만
+
+  for (size_t n = 0; n < SCAN_LIMIT; n++) {
+    struct frame *f = &frame_table[hand_cold];
+    hand_cold = (hand_cold + 1) % frame_cnt;
+    scan_cnt++;
+    if (!frame_evictable(f)) continue;
+
+    if (fallback == NULL) fallback = f;
+    if (frame_referenced(f)) continue;
+    if (!frame_protected(f)) return f;
+    if (spare == NULL) spare = f;
+  }
+  return spare != NULL ? spare : fallback;
 }
 
-/* Handle the fault on write_protected page */
-static bool vm_handle_wp(struct page *page UNUSED) {}
-
-/* Return true on success */
-bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
-                         bool user UNUSED, bool write UNUSED,
-                         bool not_present UNUSED) {
-  struct supplemental_page_table *spt UNUSED = &thread_current()->spt;
-  struct page *page = NULL;
-  void *rsp = user ? f->rsp : thread_current()->user_rsp;
+/* Second-chance clock over the frames only T maps, for a process over
+ * its resident set limit.  Returns NULL if T has no evictable frame. */
+static struct frame *local_get_victim(struct thread *t) {
+  struct frame *fallback = NULL;
+
+  for (size_t n = 0; n < SCAN_LIMIT; n++) {
+    struct frame *f = &frame_table[hand_cold];
+    hand_cold = (hand_cold + 1) % frame_cnt;
+    scan_cnt++;
+    if (!frame_evictable(f) || list_size(&f->pages) != 1 ||
+        frame_page(f)->owner != t) {
+      continue;
+    }
 
-  /* TODO: Validate the fault */
-  /* TODO: Your code goes here */
-  // 잘못된 주소 접근
-  if (!addr || !is_user_vaddr(addr)) return false;
+    if (fallback == NULL) fallback = f;
+    if (!frame_referenced(f)) return f;
+  }
+  return fallback;
+}
 
-  // writing read-only page (exception.c, page_fault 함수 참고)
-  if (!not_present) return false;
+/* CLOCK-Pro style victim selection: HAND_COLD only ever evicts cold frames.
+ * A referenced cold frame starts its test period, and a second reference
+ * during the test period promotes it to hot. */
+static struct frame *clockpro_get_victim(void) {
+  struct frame *fallback = NULL;
+  struct frame *spare = NULL;  // 몫 안의 프로세스 frame. 다른 후보가 없을 때만
+
+  for (size_t n = 0; n < SCAN_LIMIT; n++) {
+    struct frame *f = &frame_table[hand_cold];
+    hand_cold = (hand_cold + 1) % frame_cnt;
+    scan_cnt++;
+    if (!frame_evictable(f)) continue;
+
+    if (f->hot) {
+      if (fallback == NULL) fallback = f;
+      continue;
+    }
+    if (!frame_referenced(f)) {
+      if (!frame_protected(f)) return f;
+      if (spare == NULL) spare = f;
+      continue;
+    }
 
-  // spt에서 가상 주소 addr이 포함된 페이지 찾기
-  page = spt_find_page(spt, addr);
-  if (page == NULL) {
-    if (is_stack_addr(addr, rsp)) {
-      vm_stack_growth(addr);
-      page = spt_find_page(spt, addr);
-      ASSERT(page != NULL);
+    if (f->test) {
+      // 테스트 기간 중 재참조 → hot 승격
+      f->test = false;
+      f->hot = true;
+      hot_cnt++;
+      hand_hot_run();
     } else {
-      return false;
+      f->test = true;
     }
   }
 
-  // writing read-only page (not_present page 매핑 이후 확인)
-  if (write && !page->writable) return false;
+  if (spare != NULL) return spare;
 
-  return vm_do_claim_page(page);
+  // cold frame이 하나도 없으면 hot을 강등시키고 hot에서라도 가져옴
+  hand_hot_run();
+  return fallback;
 }
 
-/* Free the page.
- * DO NOT MODIFY THIS FUNCTION. */
-void vm_dealloc_page(struct page *page) {
-  destroy(page);
-  free(page);
+/* Get the struct frame, that will be evicted.  If OWNER is not NULL, only
+ * its own frames are considered. */
+static struct frame *vm_get_victim(struct thread *owner) {
+  struct frame *victim;
+
+  if (owner != NULL) return local_get_victim(owner);
+  switch (vm_replace_policy) {
+    case VM_RP_CLOCK:
+      victim = clock_get_victim();
+      break;
+    case VM_RP_CLOCK_PRO:
+    default:
+      victim = clockpro_get_victim();
+      break;
+  }
+  return victim;
 }
 
-/* Claim the page that allocate on VA. */
-bool vm_claim_page(void *va) {
-  struct page *page = spt_find_page(&thread_current()->spt, va);
+/* Admits FRAME, which just got PAGE installed, into the replacement
+ * policy and drops the pin taken by vm_get_frame(). */
+static void frame_admit(struct frame *frame) {
+  lock_acquire(&frame_lock);
+  if (vm_replace_policy == VM_RP_CLOCK_PRO) {
+    size_t slot = nonres_slot(frame_page(frame));
+    uint32_t stamp = nonres_stamp[slot];
+
+    // 최근 테스트 기간 중 쫓겨났던 페이지의 재폴트 → 바로 hot
+    if (stamp != 0 && evict_clock + 1 - stamp <= frame_cnt) {
+      frame->hot = true;
+      hot_cnt++;
+      if (cold_target < frame_cnt - 1) cold_target++;
+      hand_hot_run();
+    }
+    nonres_stamp[slot] = 0;
+  }
+  frame->pin_cnt--;
+  lock_release(&frame_lock);
+}
 
-  if (page == NULL) {
-    return false;
+/* True if PAGE's contents already exist in its backing store, so evicting
+ * it costs no write: an unmodified file page, or an anon page whose swap
+ * copy is still valid. */
+static bool vm_page_is_clean(struct page *page) {
+  if (pml4_is_dirty(page->owner->pml4, page->va)) return false;
+
+  switch (VM_TYPE(page->operations->type)) {
+    case VM_FILE:
+      return true;
+    case VM_ANON:
+      return anon_has_swap_copy(page);
+#ifdef EFILESYS
+    case VM_PAGE_CACHE:
+      return true;
+#endif
+    default:
+      return false;
   }
+}
 
-  return vm_do_claim_page(page);
+/* Writes PAGE back to its backing store without evicting it. */
+static bool vm_page_writeback(struct page *page) {
+  switch (VM_TYPE(page->operations->type)) {
+    case VM_FILE:
+      return file_backed_writeback(page);
+    case VM_ANON:
+      return anon_writeback(page);
+#ifdef EFILESYS
+    case VM_PAGE_CACHE:
+      // 페이지 캐시의 swap out은 write back만 하고 frame은 그대로 둠
+      return swap_out(page);
+#endif
+    default:
+      return false;
+  }
 }
 
-/* Claim the PAGE and set up the mmu. */
-static bool vm_do_claim_page(struct page *page) {
-  struct frame *frame = vm_get_frame();
+/* True if every page mapping FRAME is clean. */
+static bool frame_is_clean(struct frame *frame) {
+  struct list_elem *e;
 
-  /* Set links */
-  frame->page = page;
-  page->frame = frame;
+  for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+       e = list_next(e)) {
+    if (!vm_page_is_clean(list_entry(e, struct page, frame_elem))) {
+      return false;
+    }
+  }
+  return true;
+}
 
-  /* TODO: Insert page table entry to map page's VA to frame's PA. */
-  if (!swap_in(page, frame->kva)) {
-    page->frame = NULL;
-    palloc_free_page(frame->kva);
-    free(frame);
-    return false;
+/* Writes FRAME back so that every page mapping it is clean.  Anon pages
+ * sharing a frame share one swap slot, so the contents go to disk once. */
+static bool frame_writeback(struct frame *frame) {
+  struct page *first = frame_page(frame);
+  struct list_elem *e;
+
+  if (!vm_page_writeback(first)) return false;
+  for (e = list_next(&first->frame_elem); e != list_end(&frame->pages);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, frame_elem);
+    if (VM_TYPE(page->operations->type) == VM_ANON &&
+        VM_TYPE(first->operations->type) == VM_ANON) {
+      anon_swap_share(page, first);
+      pml4_set_dirty(page->owner->pml4, page->va, false);
+    } else if (!vm_page_writeback(page)) {
+      return false;
+    }
   }
+  return true;
+}
 
-  if (!pml4_set_page(thread_current()->pml4, page->va, frame->kva,
-                     page->writable)) {
-    page->frame = NULL;
-    palloc_free_page(frame->kva);
-    free(frame);
+/* Unmaps every page of VICTIM, which must be clean, and unlinks them,
+ * leaving the frame empty.  Returns false, changing nothing, if a page
+ * turned out to be dirty after all.  Every mapping is checked and
+ * cleared with interrupts off, so no store can slip in between.  Must be
+ * called with frame_lock held. */
+static bool frame_unmap_clean(struct frame *victim, bool dirty) {
+  struct list_elem *e;
+
+  enum intr_level old_level = intr_disable();
+  if (!frame_is_clean(victim)) {
+    intr_set_level(old_level);
     return false;
   }
+  // 깨끗하므로 swap_out은 디스크 쓰기 없이 끝나고, 실패하면 아무것도 바꾸지 않음
+  for (e = list_begin(&victim->pages); e != list_end(&victim->pages);
+       e = list_next(e)) {
+    if (!swap_out(list_entry(e, struct page, frame_elem))) {
+      intr_set_level(old_level);
+      return false;
+    }
+  }
+  for (e = list_begin(&victim->pages); e != list_end(&victim->pages);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, frame_elem);
+    pml4_clear_page(page->owner->pml4, page->va);
+  }
+  intr_set_level(old_level);
 
+  // 테스트 기간 중 쫓겨나는 페이지는 non-resident test 페이지로 기록
+  if (victim->test) {
+    nonres_stamp[nonres_slot(frame_page(victim))] = evict_clock + 1;
+  }
+  evict_clock++;
+  frame_forget(victim);
+
+  // 공유 중인 모든 페이지의 연결 끊기
+  while (!list_empty(&victim->pages)) {
+    struct page *page = frame_page(victim);
+    frame_unlink(page);
+    vmstat_evict(page, dirty);
+  }
   return true;
 }
 
-/* Initialize new supplemental page table */
-void supplemental_page_table_init(struct supplemental_page_table *spt) {
-  ASSERT(spt != NULL);
+/* Writes back the CNT frames of BATCH, which frame_io_begin() marked,
+ * with frame_lock released, storing in OK[i] whether frame I made it to
+ * its backing store.  Dirty anon pages go to consecutive swap slots with
+ * one command.  Must be called with frame_lock held; returns with it
+ * held. */
+static void frame_writeback_batch(struct frame **batch, bool *ok,
+                                  size_t cnt) {
+  struct page *anon_batch[EVICT_BATCH];
+  size_t anon_cnt = 0;
+
+  for (size_t i = 0; i < cnt; i++) {
+    struct page *first = frame_page(batch[i]);
+    if (VM_TYPE(first->operations->type) == VM_ANON &&
+        !vm_page_is_clean(first)) {
+      anon_batch[anon_cnt++] = first;
+    }
+  }
+  lock_release(&frame_lock);
+
+  // dirty anon 후보는 연속된 swap 슬롯에 한 번의 명령으로 기록
+  if (anon_cnt > 1) anon_writeback_cluster(anon_batch, anon_cnt);
 
-  bool success = hash_init(&spt->page_map, page_hash, page_less, NULL);
-  if (!success) {
-    PANIC("hash_init failed in supplemental_page_table_init");
+  // 나머지(파일 페이지, 공유 페이지 등)를 write back
+  size_t written = 0;
+  for (size_t i = 0; i < cnt; i++) {
+    ok[i] = frame_writeback(batch[i]);
+    if (ok[i]) written++;
   }
+  vmstat_writeback(written);
+  lock_acquire(&frame_lock);
 }
 
-/* Copy supplemental page table from src to dst */
-bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
-                                  struct supplemental_page_table *src UNUSED) {
-  supplemental_page_table_init(dst);
-
-  struct hash_iterator it;
-  hash_first(&it, &src->page_map);
-  while (hash_next(&it)) {
-    struct hash_elem *e = hash_cur(&it);
-    struct page *p = hash_entry(e, struct page, hash_elem);
+/* Evict one frame and return it.
+ * Return NULL on error.
+ * Must be called with frame_lock held.  No I/O is done under it: clean
+ * victims are preferred, and dirty candidates the policy hands out on
+ * the way are collected.  If no clean frame shows up within EVICT_BATCH
+ * candidates, the batch is pinned and written back with frame_lock
+ * released, and a frame of the batch whose write-back succeeded and that
+ * is still clean and unpinned is evicted.  Every page mapping the victim,
+ * copy-on-write sharers included, is unmapped. */
+static struct frame *vm_evict_frame(struct thread *owner) {
+  if (owner == NULL) rss_share_update();
+
+  for (size_t round = 0; round < EVICT_ROUNDS; round++) {
+    struct frame *batch[EVICT_BATCH];
+    bool ok[EVICT_BATCH];
+    size_t batch_cnt = 0;
+    struct frame *victim = NULL;
+
+    while (batch_cnt < EVICT_BATCH) {
+      struct frame *f = vm_get_victim(owner);
+      if (f == NULL) break;
+      if (frame_is_clean(f)) {
+        victim = f;
+        break;
+      }
 
-    void *va = p->va;
-    bool writable = p->writable;
+      // policy가 같은 frame을 다시 주면 더 볼 후보가 없는 것
+      bool seen = false;
+      for (size_t i = 0; i < batch_cnt; i++) {
+        if (batch[i] == f) seen = true;
+      }
+      if (seen) break;
+      batch[batch_cnt++] = f;
+    }
 
-    if (page_get_type(p) == VM_FILE) {
+    if (victim != NULL && frame_unmap_clean(victim, false)) return victim;
+    if (batch_cnt == 0) {
+      if (victim == NULL) return NULL;
       continue;
     }
 
-    if (VM_TYPE(p->operations->type) == VM_UNINIT) {
-      /* 1) UNINIT Page */
-
-      struct segment_aux *aux_src = p->uninit.aux;
+    // I/O 동안 pin해서 policy가 다시 고르지 않게 하고, 페이지 목록도 고정
+    for (size_t i = 0; i < batch_cnt; i++) {
+      frame_io_begin(batch[i]);
+    }
+    frame_writeback_batch(batch, ok, batch_cnt);
+    for (size_t i = 0; i < batch_cnt; i++) {
+      frame_io_end(batch[i]);
+    }
+    cond_broadcast(&frame_io_done, &frame_lock);
 
-      /* aux 깊은 복사 */
-      struct segment_aux *aux_dst = malloc(sizeof *aux_dst);
-      if (aux_dst == NULL) {
-        supplemental_page_table_kill(dst);
-        return false;
+    // write back에 성공했고 그 사이 다시 쓰이거나 pin되지 않은 frame만 victim
+    for (size_t i = 0; i < batch_cnt; i++) {
+      if (ok[i] && frame_evictable(batch[i]) &&
+          frame_unmap_clean(batch[i], true)) {
+        return batch[i];
       }
+    }
+  }
+  return NULL;
+}
 
-      enum vm_type t = p->uninit.type;
-      *aux_dst = *aux_src;
-      if (VM_TYPE(t) == VM_FILE) {
-        continue;
-      }
+/* palloc() and get frame. If there is no available page, evict the page
+ * and return it. This always return valid address. That is, if the user pool
+ * memory is full, this function evicts the frame to get the available memory
+ * space.
+ * The returned frame is pinned until the caller finished installing it. */
+static struct frame *vm_get_frame(void) {
+  struct frame *frame;
 
-      if (!vm_alloc_page_with_initializer(t, va, writable, p->uninit.init,
-                                          aux_dst)) {
-        if (VM_TYPE(t) == VM_FILE && aux_dst->file != NULL) {
-          file_close(aux_dst->file);
-        }
-        free(aux_dst);
-        supplemental_page_table_kill(dst);
-        return false;
+  bool wake = false;
+
+  lock_acquire(&frame_lock);
+  // rss 상한을 넘은 프로세스는 자기 페이지를 내보내고 그 frame을 재사용
+  frame = NULL;
+  if (rss_over_limit(thread_current())) {
+    frame = vm_evict_frame(thread_current());
+    if (frame != NULL) rss_local_evictions++;
+  }
+  if (frame == NULL) {
+    void *kva = palloc_get_page(PAL_USER);
+    if (kva != NULL) {
+      frame = vm_kva_to_frame(kva);
+      ASSERT(list_empty(&frame->pages));
+      frame_used++;
+    } else {
+      frame = vm_evict_frame(NULL);
+    }
+  }
+  if (frame != NULL) frame->pin_cnt = 1;
+
+  // free frame이 low watermark 아래로 내려가면 page-out daemon을 깨움
+  if (frame_capacity - frame_used < vm_low_watermark && !pageout_pending) {
+    pageout_pending = true;
+    wake = true;
+  }
+  lock_release(&frame_lock);
+
+  if (wake) sema_up(&pageout_wakeup);
+  return frame;
+}
+
+/* Returns a free frame for speculative use, such as reading ahead of a
+ * fault, or NULL if that would push free memory below the low watermark.
+ * Never evicts.  The frame is pinned until vm_map_frame(). */
+struct frame *vm_get_spare_frame(void) {
+  struct frame *frame = NULL;
+
+  lock_acquire(&frame_lock);
+  if (frame_capacity - frame_used > vm_low_watermark) {
+    void *kva = palloc_get_page(PAL_USER);
+    if (kva != NULL) {
+      frame = vm_kva_to_frame(kva);
+      ASSERT(list_empty(&frame->pages));
+      frame->pin_cnt = 1;
+      frame_used++;
+    }
+  }
+  lock_release(&frame_lock);
+  return frame;
+}
+
+/* Maps FRAME from vm_get_spare_frame(), already filled with PAGE's
+ * contents, at PAGE's address.  On failure the frame is released. */
+bool vm_map_frame(struct page *page, struct frame *frame) {
+  lock_acquire(&frame_lock);
+  frame_link(frame, page);
+  lock_release(&frame_lock);
+
+  if (!pml4_set_page(page->owner->pml4, page->va, frame->kva,
+                     page->writable)) {
+    vm_frame_unlink(page);
+    return false;
+  }
+
+  lock_acquire(&frame_lock);
+  frame_publish(frame, page);
+  lock_release(&frame_lock);
+  frame_admit(frame);
+  return true;
+}
+
+static uint64_t page_index_hash(const struct hash_elem *e,
+                                void *aux UNUSED) {
+  const struct frame *f = hash_entry(e, struct frame, index_elem);
+  return hash_bytes(&f->inode, sizeof f->inode) ^ hash_int(f->ofs / PGSIZE);
+}
+
+static bool page_index_less(const struct hash_elem *a,
+                            const struct hash_elem *b, void *aux UNUSED) {
+  const struct frame *fa = hash_entry(a, struct frame, index_elem);
+  const struct frame *fb = hash_entry(b, struct frame, index_elem);
+  if (fa->inode != fb->inode) return fa->inode < fb->inode;
+  return fa->ofs < fb->ofs;
+}
+
+/* Stores in KEY where in which file the contents of file-backed PAGE
+ * come from, lazy or not.  Returns false if PAGE cannot be shared: it is
+ * anonymous or holds no file bytes at all. */
+static bool page_index_key(struct page *page, struct frame *key) {
+#ifdef EFILESYS
+  // 페이지 캐시 페이지는 파일 페이지 전체를 가짐
+  if (page_get_type(page) == VM_PAGE_CACHE) {
+    key->inode = page->page_cache.inode;
+    key->ofs = page->page_cache.ofs;
+    key->read_bytes = PGSIZE;
+    return true;
+  }
+#endif
+  if (page_get_type(page) != VM_FILE) return false;
+
+  struct file *file;
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+    struct segment_aux *aux = page->uninit.aux;
+    if (aux == NULL) return false;
+    file = aux->file;
+    key->ofs = aux->ofs;
+    key->read_bytes = aux->read_bytes;
+  } else {
+    file = page->file.file;
+    key->ofs = page->file.ofs;
+    key->read_bytes = page->file.read_bytes;
+  }
+  if (file == NULL || key->read_bytes == 0) return false;
+
+  key->inode = file_get_inode(file);
+  return true;
+}
+
+/* Publishes FRAME, into which PAGE was just read, in the page index
+ * unless the same file page is already resident elsewhere.  With the page
+ * cache only its frames are published; a user page that could not map
+ * one keeps its copy to itself.  Must be called with frame_lock held. */
+static void frame_publish(struct frame *frame, struct page *page) {
+  struct frame key;
+#ifdef EFILESYS
+  if (page_get_type(page) != VM_PAGE_CACHE) return;
+#endif
+  if (!page_index_key(page, &key)) return;
+
+  frame->inode = key.inode;
+  frame->ofs = key.ofs;
+  frame->read_bytes = key.read_bytes;
+  if (hash_insert(&page_index, &frame->index_elem) != NULL) {
+    frame->inode = NULL;
+    return;
+  }
+  // 다른 프로세스가 붙을 수 있으니 첫 쓰기는 vm_handle_wp()를 거침
+  if (page->writable && page_get_type(page) == VM_FILE) {
+    pml4_set_writable(page->owner->pml4, page->va, false);
+  }
+}
+
+/* Removes FRAME from the page index, if it is published.  Must be called
+ * with frame_lock held. */
+static void frame_unpublish(struct frame *frame) {
+  if (frame->inode != NULL) {
+    hash_delete(&page_index, &frame->index_elem);
+    frame->inode = NULL;
+  }
+}
+
+/* Drops from the page index the frames of INODE that a write of SIZE
+ * bytes at OFS has made stale.  Pages that map them already keep them;
+ * later faults read the new contents. */
+void vm_file_written(struct inode *inode, off_t ofs, off_t size) {
+  struct frame key;
+
+  key.inode = inode;
+  lock_acquire(&frame_lock);
+  for (key.ofs = ROUND_DOWN(ofs, PGSIZE); key.ofs < ofs + size;
+       key.ofs += PGSIZE) {
+    struct hash_elem *e = hash_find(&page_index, &key.index_elem);
+    if (e != NULL) frame_unpublish(hash_entry(e, struct frame, index_elem));
+  }
+  lock_release(&frame_lock);
+}
+
+/* True if PAGE, which shows the first READ_BYTES bytes of the file page
+ * FRAME holds, may map FRAME.  Two user pages must agree on writability
+ * and on where the file ends: a read-only executable page never shares
+ * with a writable mapping of the same file.  A page cache frame is not
+ * mapped by the user and holds the whole file page, so any mmap page of
+ * it fits, as does an executable page that fills it. */
+static bool frame_fits(struct frame *frame, struct page *page,
+                       size_t read_bytes) {
+  struct page *first = frame_page(frame);
+#ifdef EFILESYS
+  if (page_get_type(first) == VM_PAGE_CACHE) {
+    return page->vma != NULL || read_bytes == frame->read_bytes;
+  }
+#endif
+  return frame->read_bytes == read_bytes && first->writable == page->writable;
+}
+
+/* Maps non-resident PAGE to a resident frame that already holds the same
+ * file page, found in the page index, if frame_fits() allows.  A user
+ * frame is mapped read-only, so a write copies it.  Returns false if
+ * there is no such frame. */
+static bool frame_attach(struct page *page) {
+  struct frame key;
+  if (!page_index_key(page, &key)) return false;
+
+  lock_acquire(&frame_lock);
+  struct hash_elem *e = hash_find(&page_index, &key.index_elem);
+  struct frame *frame =
+      e != NULL ? hash_entry(e, struct frame, index_elem) : NULL;
+  // write back 중인 frame은 곧 쫓겨날 수 있으니 따로 읽음
+  if (frame == NULL || frame->io || !frame_fits(frame, page, key.read_bytes)) {
+    lock_release(&frame_lock);
+    return false;
+  }
+
+  // lazy 실행 파일 페이지는 읽지 않고 파일 페이지로만 전환
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+    void *aux = page->uninit.aux;
+    file_backed_initializer(page, VM_FILE, frame->kva);
+    free(aux);
+  }
+  // 페이지 캐시 frame만 같이 씀. 사용자 frame은 쓰면 복사됨
+#ifdef EFILESYS
+  bool writable = page->writable;
+#else
+  bool writable = false;
+#endif
+  frame_link(frame, page);
+  frame->pin_cnt++;
+  page_index_hits++;
+  lock_release(&frame_lock);
+
+  if (!pml4_set_page(page->owner->pml4, page->va, frame->kva, writable)) {
+    lock_acquire(&frame_lock);
+    frame->pin_cnt--;
+    lock_release(&frame_lock);
+    vm_frame_unlink(page);
+    return false;
+  }
+  frame_admit(frame);
+  return true;
+}
+
+/* Writes PAGE back to its backing store if it is resident and dirty,
+ * keeping it resident and clearing its dirty bit.  With ASYNC the write
+ * is only scheduled and left to the page-out daemon. */
+bool vm_sync_page(struct page *page, bool async) {
+  bool wake = false;
+
+  lock_acquire(&frame_lock);
+  struct frame *frame = page->frame;
+  if (frame == NULL || !pml4_is_dirty(page->owner->pml4, page->va)) {
+    lock_release(&frame_lock);
+    return true;
+  }
+  if (async) {
+    if (!frame->flush) {
+      frame->flush = true;
+      flush_cnt++;
+    }
+    if (!pageout_pending) {
+      pageout_pending = true;
+      wake = true;
+    }
+    lock_release(&frame_lock);
+    if (wake) sema_up(&pageout_wakeup);
+    return true;
+  }
+
+  // I/O 동안 eviction되지 않도록 pin
+  frame->pin_cnt++;
+  lock_release(&frame_lock);
+
+  bool success = vm_page_writeback(page);
+  if (success) vmstat_writeback(1);
+
+  lock_acquire(&frame_lock);
+  frame->pin_cnt--;
+  sync_writebacks++;
+  lock_release(&frame_lock);
+  return success;
+}
+
+/* Writes back every frame msync(MS_ASYNC) scheduled, EVICT_BATCH at a
+ * time.  Each batch is collected and pinned under frame_lock and written
+ * with it released, as in vm_evict_frame().  Must be called with
+ * frame_lock held; returns with it held. */
+static void pageout_flush(void) {
+  size_t i = 0;
+
+  while (i < frame_cnt && flush_cnt > 0) {
+    struct frame *batch[EVICT_BATCH];
+    bool ok[EVICT_BATCH];
+    size_t cnt = 0;
+
+    for (; i < frame_cnt && cnt < EVICT_BATCH; i++) {
+      struct frame *f = &frame_table[i];
+      if (!f->flush) continue;
+
+      f->flush = false;
+      flush_cnt--;
+      if (frame_evictable(f)) {
+        frame_io_begin(f);
+        batch[cnt++] = f;
       }
-    } else if (page_get_type(p) == VM_ANON) {
-      /* 2) 이미 적재된 ANON 페이지 */
+    }
+    if (cnt == 0) continue;
+
+    frame_writeback_batch(batch, ok, cnt);
+    for (size_t j = 0; j < cnt; j++) {
+      frame_io_end(batch[j]);
+      if (ok[j]) async_writebacks++;
+    }
+    cond_broadcast(&frame_io_done, &frame_lock);
+  }
+}
 
-      /* 부모가 swap/evict 미구현 단계라면 frame은 있어야 정상 */
-      ASSERT(p->frame != NULL);
+/* Picks default watermarks if none were given and starts the page-out
+ * daemon. */
+static void pageout_init(void) {
+  if (vm_low_watermark == 0) {
+    vm_low_watermark = frame_capacity / 64 > 4 ? frame_capacity / 64 : 4;
+  }
+  if (vm_high_watermark <= vm_low_watermark) {
+    vm_high_watermark = vm_low_watermark * 2;
+  }
+  if (vm_high_watermark > frame_capacity / 2) {
+    vm_high_watermark = frame_capacity / 2;
+  }
+  if (vm_low_watermark > vm_high_watermark) {
+    vm_low_watermark = vm_high_watermark;
+  }
 
-      if (!vm_alloc_page_with_initializer(VM_ANON, va, writable, NULL, NULL)) {
-        supplemental_page_table_kill(dst);
-        return false;
+  sema_init(&pageout_wakeup, 0);
+  if (thread_create("pageoutd", PRI_DEFAULT, pageout_daemon, NULL) ==
+      TID_ERROR) {
+    PANIC("failed to start page-out daemon");
+  }
+}
+
+/* Page-out daemon thread.  Writes back the frames msync() scheduled,
+ * then evicts one frame at a time until the high watermark of free
+ * frames is reached.  Write-back I/O is done with frame_lock released,
+ * and the lock is dropped between evictions, so faulting threads only
+ * wait for the daemon's bookkeeping, never for its disk writes. */
+static void pageout_daemon(void *aux UNUSED) {
+  while (true) {
+    sema_down(&pageout_wakeup);
+    pageout_wakeups++;
+
+    while (true) {
+      lock_acquire(&frame_lock);
+      if (flush_cnt > 0) pageout_flush();
+      if (frame_capacity - frame_used >= vm_high_watermark) {
+        pageout_pending = false;
+        lock_release(&frame_lock);
+        break;
       }
 
-      if (!vm_claim_page(va)) {
-        supplemental_page_table_kill(dst);
-        return false;
+      uint64_t scan_start = scan_cnt;
+      struct frame *frame = vm_evict_frame(NULL);
+      pageout_scanned += scan_cnt - scan_start;
+      if (frame == NULL) {
+        // 쫓아낼 frame이 없음. 다음 wakeup까지 대기
+        pageout_pending = false;
+        lock_release(&frame_lock);
+        break;
+      }
+      palloc_free_page(frame->kva);
+      frame_used--;
+      pageout_reclaimed++;
+      lock_release(&frame_lock);
+
+      thread_yield();
+    }
+  }
+}
+
+/* True if FRAME may be merged: resident, unpinned anonymous memory. */
+static bool ksm_candidate(struct frame *frame) {
+  struct list_elem *e;
+
+  if (!frame_evictable(frame)) return false;
+  for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, frame_elem);
+    if (VM_TYPE(page->operations->type) != VM_ANON) return false;
+  }
+  return true;
+}
+
+/* Makes every mapping of FRAME read-only, so its contents cannot change
+ * without a fault, which waits for frame_lock. */
+static void frame_write_protect(struct frame *frame) {
+  struct list_elem *e;
+
+  for (e = list_begin(&frame->pages); e != list_end(&frame->pages);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, frame_elem);
+    pml4_set_writable(page->owner->pml4, page->va, false);
+  }
+}
+
+/* Undoes frame_write_protect() on FRAME.  A frame shared copy-on-write
+ * stays read-only; a frame mapped once gets back write access if its
+ * page is writable, as vm_handle_wp() would give it on the next write. */
+static void frame_write_unprotect(struct frame *frame) {
+  if (list_size(&frame->pages) != 1) return;
+
+  struct page *page = frame_page(frame);
+  if (page->writable) pml4_set_writable(page->owner->pml4, page->va, true);
+}
+
+/* Moves every page of FROM onto INTO, which holds the same bytes, mapped
+ * read-only, and frees FROM.  Dirty bits carry over, so a page whose
+ * swap copy is stale is still written back on eviction.  Returns false,
+ * leaving every page mapped read-only on FROM, if a mapping could not be
+ * replaced. */
+static bool ksm_merge(struct frame *from, struct frame *into) {
+  struct list_elem *e, *failed = NULL;
+
+  for (e = list_begin(&from->pages); e != list_end(&from->pages);
+       e = list_next(e)) {
+    struct page *page = list_entry(e, struct page, frame_elem);
+    uint64_t *pml4 = page->owner->pml4;
+    bool dirty = pml4_is_dirty(pml4, page->va);
+
+    pml4_clear_page(pml4, page->va);
+    if (!pml4_set_page(pml4, page->va, into->kva, false)) {
+      failed = e;
+      break;
+    }
+    if (dirty) pml4_set_dirty(pml4, page->va, true);
+  }
+
+  if (failed != NULL) {
+    // 옮긴 PTE를 FROM으로 되돌림. PTE 자리는 이미 있으므로 다시 실패하지 않음
+    for (e = list_begin(&from->pages);; e = list_next(e)) {
+      struct page *page = list_entry(e, struct page, frame_elem);
+      uint64_t *pml4 = page->owner->pml4;
+      bool dirty = pml4_is_dirty(pml4, page->va);
+
+      pml4_clear_page(pml4, page->va);
+      if (!pml4_set_page(pml4, page->va, from->kva, false)) NOT_REACHED();
+      if (dirty) pml4_set_dirty(pml4, page->va, true);
+      if (e == failed) break;
+    }
+    return false;
+  }
+
+  while (!list_empty(&from->pages)) {
+    struct page *page = frame_page(from);
+    frame_unlink(page);
+    frame_link(into, page);
+  }
+  frame_forget(from);
+  palloc_free_page(from->kva);
+  frame_used--;
+  ksm_merged++;
+  return true;
+}
+
+/* Checksums FRAME and merges it with an identical stable frame, if one
+ * is known.  Must be called with frame_lock held. */
+static void ksm_scan_frame(struct frame *frame) {
+  uint64_t sum = hash_bytes(frame->kva, PGSIZE);
+  ksm_scanned++;
+
+  // 지난 pass 이후 바뀐 frame은 아직 합치지 않음
+  if (sum != frame->ksm_sum) {
+    frame->ksm_sum = sum;
+    return;
+  }
+
+  struct frame **slot = &ksm_slots[sum % frame_cnt];
+  struct frame *other = *slot;
+  if (other == NULL || other == frame || other->ksm_sum != sum ||
+      !ksm_candidate(other)) {
+    *slot = frame;
+    return;
+  }
+
+  if (memcmp(frame->kva, other->kva, PGSIZE) != 0) return;
+
+  // 보호한 뒤 다시 비교. 그 사이에 쓰였다면 쓰기 권한을 돌려줌
+  frame_write_protect(frame);
+  frame_write_protect(other);
+  if (memcmp(frame->kva, other->kva, PGSIZE) != 0 ||
+      !ksm_merge(frame, other)) {
+    frame_write_unprotect(frame);
+    frame_write_unprotect(other);
+  }
+}
+
+/* Same-page merging thread.  Runs at the lowest priority and takes
+ * frame_lock for one frame at a time. */
+static void ksm_daemon(void *aux UNUSED) {
+  while (true) {
+    timer_sleep(KSM_SLEEP);
+
+    for (size_t n = 0; n < vm_ksm_pages && n < frame_cnt; n++) {
+      lock_acquire(&frame_lock);
+      struct frame *frame = &frame_table[ksm_hand];
+      ksm_hand = (ksm_hand + 1) % frame_cnt;
+      if (ksm_candidate(frame)) ksm_scan_frame(frame);
+      lock_release(&frame_lock);
+    }
+  }
+}
+
+/* Starts the same-page merging thread. */
+static void ksm_init(void) {
+  ksm_slots = calloc(frame_cnt, sizeof *ksm_slots);
+  if (ksm_slots == NULL) {
+    PANIC("KSM table allocation failed");
+  }
+  if (thread_create("ksmd", PRI_MIN, ksm_daemon, NULL) == TID_ERROR) {
+    PANIC("failed to start KSM daemon");
+  }
+}
+
+/* Prints virtual memory statistics. */
+void vm_print_stats(void) {
+  printf("Page-out: %llu wakeups, %llu pages scanned, %llu pages reclaimed\n",
+         pageout_wakeups, pageout_scanned, pageout_reclaimed);
+  printf("Faults: %llu minor, %llu stack, %llu elf, %llu mmap, %llu swap-in, "
+         "%llu write-protect\n",
+         vm_stats.minor_faults, vm_stats.stack_faults, vm_stats.elf_faults,
+         vm_stats.mmap_faults, vm_stats.swapin_faults, vm_stats.wp_faults);
+  printf("Evictions: %llu clean, %llu dirty\n", vm_stats.clean_evictions,
+         vm_stats.dirty_evictions);
+  anon_print_stats();
+  printf("Fault-around: %llu pages mapped ahead of faults\n",
+         fault_around_pages);
+  printf("Page index: %llu faults served from a shared frame\n",
+         page_index_hits);
+  printf("msync: %llu pages written back, %llu frames flushed by pageoutd\n",
+         sync_writebacks, async_writebacks);
+  printf("Zero page: %llu read faults mapped without a frame\n",
+         zero_page_maps);
+  printf("Exec prefault: %llu pages mapped with %llu batched reads\n",
+         prefault_pages, prefault_reads);
+  printf("RSS: %llu evictions by processes over their limit\n",
+         rss_local_evictions);
+  printf("Commit: %zu of %zu pages committed, %llu requests refused\n",
+         committed, commit_limit, commit_refused);
+  if (vm_ksm_pages > 0) {
+    printf("KSM: %llu frames scanned, %llu merged (%llu KiB reclaimed)\n",
+           ksm_scanned, ksm_merged, ksm_merged * (PGSIZE / 1024));
+  }
+}
+
+/* 스택 주소인지 체크 */
+bool is_stack_addr(void *addr, void *rsp) {
+  // 잘못된 주소(NULL, 커널 가상 주소) 접근
+  if (!addr || !is_user_vaddr(addr)) return false;
+
+  // 유저 스택 주소가 아닌 경우
+  if (addr >= USER_STACK) return false;
+
+  // 유저 스택 범위를 넘어간 경우(스택 오버 플로우)
+  if (pg_round_down(addr) < USER_STACK - MAX_STACK_SIZE) return false;
+
+  // x86-64, PUSH 명령어에 의한 경우를 제외하고 스택 포인터를 벗어난 접근
+  if (addr < rsp - 8) return false;
+
+  return true;
+}
+
+/* Growing the stack.  Returns false if no memory can be committed. */
+static bool vm_stack_growth(void *addr) {
+  void *upage = pg_round_down(addr);
+
+  return vm_alloc_page(VM_ANON | VM_MARKER_0, upage, true);
+}
+
+/* Handle the fault on write_protected page.
+ * PAGE is writable but mapped read-only because its frame is shared
+ * copy-on-write.  The last sharer simply gets write access back; any
+ * other sharer gets a private copy of the frame. */
+static bool vm_handle_wp(struct page *page) {
+  uint64_t *pml4 = page->owner->pml4;
+
+  lock_acquire(&frame_lock);
+  struct frame *old = frame_io_wait(page);
+  if (old == NULL) {
+    // zero page에 대한 첫 쓰기이거나 폴트 처리 전에 evict 됨. 새 frame에 채움
+    lock_release(&frame_lock);
+    return vm_do_claim_page(page);
+  }
+  bool shared_file = false;
+#ifdef EFILESYS
+  // 페이지 캐시 frame은 파일 내용 그 자체라 복사하지 않고 같이 씀
+  shared_file = page_get_type(frame_page(old)) == VM_PAGE_CACHE;
+#endif
+  if (list_size(&old->pages) == 1 || shared_file) {
+    // 혼자 쓰게 된 파일 frame은 index에서 빼서 더는 공유되지 않게 함
+    if (!shared_file) frame_unpublish(old);
+    pml4_set_writable(pml4, page->va, true);
+    lock_release(&frame_lock);
+    return true;
+  }
+  old->pin_cnt++;
+  lock_release(&frame_lock);
+
+  struct frame *frame = vm_get_frame();
+  if (frame == NULL) {
+    lock_acquire(&frame_lock);
+    old->pin_cnt--;
+    lock_release(&frame_lock);
+    return false;
+  }
+  memcpy(frame->kva, old->kva, PGSIZE);
+
+  lock_acquire(&frame_lock);
+  frame_unlink(page);
+  old->pin_cnt--;
+  frame_link(frame, page);
+  lock_release(&frame_lock);
+
+  // 공유하던 swap 사본은 이제 이 페이지의 것이 아님
+  if (VM_TYPE(page->operations->type) == VM_ANON) {
+    anon_swap_unshare(page);
+  }
+
+  pml4_clear_page(pml4, page->va);
+  if (!pml4_set_page(pml4, page->va, frame->kva, true)) {
+    vm_frame_unlink(page);
+    return false;
+  }
+  frame_admit(frame);
+  return true;
+}
+
+/* True if PAGE is an anonymous page that holds only zeros because it was
+ * never written: untouched stack or BSS, or a page only read so far. */
+static bool page_is_zero_fill(struct page *page) {
+  switch (VM_TYPE(page->operations->type)) {
+    case VM_UNINIT: {
+      if (VM_TYPE(page->uninit.type) != VM_ANON) return false;
+      if (page->uninit.init == NULL) return true;
+
+      struct segment_aux *aux = page->uninit.aux;
+      return page->uninit.init == lazy_load_segment && aux != NULL &&
+             aux->read_bytes == 0;
+    }
+    case VM_ANON:
+      return page->frame == NULL && !anon_has_swap_copy(page);
+    default:
+      return false;
+  }
+}
+
+/* Maps the shared zero page read-only at PAGE, a page for which
+ * page_is_zero_fill() holds, without giving it a frame. */
+static bool vm_map_zero_page(struct page *page) {
+  if (VM_TYPE(page->operations->type) == VM_UNINIT) {
+    void *aux = page->uninit.aux;
+    anon_initializer(page, page->uninit.type, NULL);
+    free(aux);
+  }
+  if (!pml4_set_page(page->owner->pml4, page->va, zero_page, false)) {
+    return false;
+  }
+  zero_page_maps++;
+  return true;
+}
+
+/* Returns the segment_aux of PAGE if it is a lazy page still to be read
+ * from a file, or NULL. */
+static struct segment_aux *uninit_segment(struct page *page) {
+  if (VM_TYPE(page->operations->type) != VM_UNINIT) return NULL;
+
+  struct segment_aux *aux = page->uninit.aux;
+  if (aux == NULL || aux->file == NULL || aux->read_bytes == 0) return NULL;
+  return aux;
+}
+
+/* Populates the pages around PAGE, which was just read from offset OFS
+ * of FILE, that map the following or preceding bytes of the same file:
+ * lazy ELF pages of the same segment, or non-resident pages of the same
+ * VMA, which are created as needed.  Stops quietly when no spare frame
+ * is left. */
+static void fault_around(struct page *page, struct file *file, off_t ofs) {
+  struct supplemental_page_table *spt = &page->owner->spt;
+  struct vma *vma = page->vma;
+  size_t window = vm_fault_around * PGSIZE;
+  uint8_t *start = (uint8_t *)((uint64_t)page->va / window * window);
+
+  for (uint8_t *va = start; va < start + window; va += PGSIZE) {
+    if (va == page->va || !is_user_vaddr(va)) continue;
+
+    struct page *p = spt_find_page(spt, va);
+    if (vma != NULL) {
+      if (vma_find(page->owner, va) != vma) continue;
+      if (p != NULL && p->frame != NULL) continue;
+    } else {
+      struct segment_aux *aux = p != NULL ? uninit_segment(p) : NULL;
+      if (aux == NULL || aux->file != file ||
+          aux->ofs != ofs + (va - (uint8_t *)page->va)) {
+        continue;
+      }
+    }
+
+    if (p == NULL && (p = vma_materialize(vma, va)) == NULL) break;
+    if (frame_attach(p)) {
+      fault_around_pages++;
+      continue;
+    }
+#ifdef EFILESYS
+    // mmap 페이지는 페이지 캐시 frame만 매핑 (따로 읽으면 사본이 어긋남)
+    if (vma != NULL) continue;
+#endif
+
+    struct frame *frame = vm_get_spare_frame();
+    if (frame == NULL) break;
+    if (!vm_install_page(p, frame)) break;
+    fault_around_pages++;
+  }
+}
+
+/* Turns lazy executable PAGE into the page its fault would have made,
+ * using the file contents already copied to FRAME, and maps it.  On
+ * failure PAGE is left lazy and FRAME is released. */
+static bool prefault_install(struct page *page, struct frame *frame) {
+  struct uninit_page lazy = page->uninit;
+  bool writable = page->writable;
+
+  lazy.page_initializer(page, lazy.type, frame->kva);
+  if (!vm_map_frame(page, frame)) {
+    uninit_new(page, page->va, lazy.init, lazy.type, lazy.aux,
+               lazy.page_initializer);
+    page->writable = writable;
+    return false;
+  }
+  free(lazy.aux);
+  return true;
+}
+
+/* Reads the CNT lazy executable PAGES, which map consecutive pages of
+ * the same file, with a single read and maps them.  Returns false if no
+ * spare frame was left for some of them. */
+static bool prefault_run(struct page **pages, size_t cnt) {
+  struct frame *frames[PREFAULT_BATCH];
+  size_t got = 0, mapped = 0;
+
+  while (got < cnt && (frames[got] = vm_get_spare_frame()) != NULL) got++;
+  if (got == 0) return false;
+
+  struct segment_aux *first = uninit_segment(pages[0]);
+  struct segment_aux *last = uninit_segment(pages[got - 1]);
+  off_t bytes = (got - 1) * PGSIZE + last->read_bytes;
+  uint8_t *buf = palloc_get_multiple(0, got);
+
+  if (buf == NULL ||
+      file_read_at(first->file, buf, bytes, first->ofs) != bytes) {
+    // 한 번에 읽지 못하면 fault 때처럼 한 페이지씩 읽음
+    for (size_t i = 0; i < got; i++) {
+      if (vm_install_page(pages[i], frames[i])) mapped++;
+    }
+  } else {
+    for (size_t i = 0; i < got; i++) {
+      size_t read_bytes = uninit_segment(pages[i])->read_bytes;
+      memcpy(frames[i]->kva, buf + i * PGSIZE, read_bytes);
+      memset(frames[i]->kva + read_bytes, 0, PGSIZE - read_bytes);
+      if (prefault_install(pages[i], frames[i])) mapped++;
+    }
+    prefault_reads++;
+  }
+  if (buf != NULL) palloc_free_multiple(buf, got);
+  prefault_pages += mapped;
+  thread_current()->vmstat.prefaulted += mapped;
+  return got == cnt;
+}
+
+/* Maps, ahead of their first access, the pages of the executable
+ * segment just set up at UPAGE whose first READ_BYTES bytes come from
+ * the file, as vm_load_policy asks: none, all of them, or under the
+ * hybrid policy all of a read-only (text) segment but only the first
+ * VM_PREFAULT_DATA pages of a writable one.  Pages another process
+ * already has resident are shared through the page index.  Zero-fill
+ * pages are left to the zero page. */
+void vm_prefault_segment(void *upage, size_t read_bytes, bool writable) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  struct page *run[PREFAULT_BATCH];
+  size_t run_cnt = 0;
+  size_t cnt = DIV_ROUND_UP(read_bytes, PGSIZE);
+
+  if (vm_load_policy == VM_LOAD_LAZY) return;
+  if (vm_load_policy == VM_LOAD_HYBRID && writable && cnt > VM_PREFAULT_DATA) {
+    cnt = VM_PREFAULT_DATA;
+  }
+
+  for (size_t i = 0; i < cnt; i++) {
+    struct page *page = spt_find_page(spt, (uint8_t *)upage + i * PGSIZE);
+    struct segment_aux *aux = page != NULL ? uninit_segment(page) : NULL;
+
+    // 지금까지 모은 run과 파일에서 이어지지 않으면 먼저 읽음
+    if (run_cnt > 0) {
+      struct segment_aux *prev = uninit_segment(run[run_cnt - 1]);
+      if (aux == NULL || aux->file != prev->file ||
+          aux->ofs != prev->ofs + PGSIZE || prev->read_bytes != PGSIZE) {
+        if (!prefault_run(run, run_cnt)) return;
+        run_cnt = 0;
       }
+    }
+    if (aux == NULL) continue;
+
+    if (frame_attach(page)) {
+      thread_current()->vmstat.prefaulted++;
+      prefault_pages++;
+      continue;
+    }
+    run[run_cnt++] = page;
+    if (run_cnt == PREFAULT_BATCH) {
+      if (!prefault_run(run, run_cnt)) return;
+      run_cnt = 0;
+    }
+  }
+  if (run_cnt > 0) prefault_run(run, run_cnt);
+}
+
+/* Returns how claiming PAGE will resolve its fault. */
+static enum vm_fault_kind fault_kind(struct page *page) {
+  switch (VM_TYPE(page->operations->type)) {
+    case VM_UNINIT:
+      return uninit_segment(page) != NULL ? FAULT_ELF : FAULT_MINOR;
+    case VM_ANON:
+      return anon_has_swap_copy(page) ? FAULT_SWAPIN : FAULT_MINOR;
+    case VM_FILE:
+      if (page->file.read_bytes == 0) return FAULT_MINOR;
+      return page->vma != NULL ? FAULT_MMAP : FAULT_ELF;
+    default:
+      return FAULT_MINOR;
+  }
+}
+
+/* Return true on success */
+bool vm_try_handle_fault(struct intr_frame *f UNUSED, void *addr UNUSED,
+                         bool user UNUSED, bool write UNUSED,
+                         bool not_present UNUSED) {
+  uint64_t start = rdtsc();
+  enum vm_fault_kind kind;
+
+  if (!vm_handle_fault(f, addr, user, write, not_present, &kind)) {
+    return false;
+  }
+  vmstat_fault(kind, rdtsc() - start);
+  return true;
+}
 
-      struct page *child_p = spt_find_page(dst, va);
-      memcpy(child_p->frame->kva, p->frame->kva, PGSIZE);
+/* Resolves the fault, storing how it did so in *KIND. */
+static bool vm_handle_fault(struct intr_frame *f, void *addr, bool user,
+                            bool write, bool not_present,
+                            enum vm_fault_kind *kind) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  struct page *page = NULL;
+  void *rsp = user ? f->rsp : thread_current()->user_rsp;
+
+  /* TODO: Validate the fault */
+  /* TODO: Your code goes here */
+  // 잘못된 주소 접근
+  if (!addr || !is_user_vaddr(addr)) return false;
+
+  // 읽기 전용 매핑에 쓰기: copy-on-write로 공유 중인 페이지인지 확인
+  if (!not_present) {
+    if (!write) return false;
+    page = spt_find_page(spt, addr);
+    if (page == NULL || !page->writable) return false;
+    *kind = FAULT_WP;
+    return vm_handle_wp(page);
+  }
+
+  // spt에서 가상 주소 addr이 포함된 페이지 찾기
+  page = spt_find_page(spt, addr);
+  if (page == NULL) {
+    struct vma *vma = vma_find(thread_current(), addr);
+    if (vma != NULL) {
+      // mmap 영역의 첫 접근: 페이지를 VMA로부터 생성
+      page = vma_materialize(vma, addr);
+      if (page == NULL) return false;
+      *kind = fault_kind(page);
+    } else if (is_stack_addr(addr, rsp)) {
+      if (!vm_stack_growth(addr)) return false;
+      page = spt_find_page(spt, addr);
+      ASSERT(page != NULL);
+      *kind = FAULT_STACK;
     } else {
-      supplemental_page_table_kill(dst);
       return false;
     }
+  } else {
+    *kind = fault_kind(page);
+  }
+
+  // writing read-only page (not_present page 매핑 이후 확인)
+  if (write && !page->writable) return false;
+
+  // 한 번도 쓰지 않은 anon 페이지를 읽기만 하면 frame 없이 zero page를 매핑
+  if (!write && page_is_zero_fill(page)) {
+    *kind = FAULT_MINOR;
+    return vm_map_zero_page(page);
   }
 
+  // 파일에서 읽어올 lazy 페이지면 claim 전에 파일 위치 기억 (aux는 해제됨)
+  struct segment_aux *aux = uninit_segment(page);
+  struct file *file = aux != NULL ? aux->file : page->file.file;
+  off_t ofs = aux != NULL ? aux->ofs : page->file.ofs;
+  bool around = aux != NULL || page->vma != NULL;
+
+  // 다른 프로세스가 같은 파일 페이지를 이미 읽어 두었으면 그 frame을 매핑
+  if (frame_attach(page)) {
+    *kind = FAULT_MINOR;
+    return true;
+  }
+  if (!vm_do_claim_page(page)) return false;
+  if (around) fault_around(page, file, ofs);
   return true;
 }
 
-// void hash_action_destroy(struct hash_elem *e, void *aux UNUSED) {
-//   ASSERT(e != NULL);
-//   struct page *page = hash_entry(e, struct page, hash_elem);
-//   ASSERT(page != NULL);
-//   vm_dealloc_page(page);
-// }
+/* Free the page.
+ * DO NOT MODIFY THIS FUNCTION. */
+void vm_dealloc_page(struct page *page) {
+  destroy(page);
+  free(page);
+}
+
+/* Claim the page that allocate on VA. */
+bool vm_claim_page(void *va) {
+  struct page *page = spt_find_page(&thread_current()->spt, va);
+
+  if (page == NULL) {
+    return false;
+  }
+
+  return vm_do_claim_page(page);
+}
+
+/* Makes the page at VA of the current process resident and privately
+ * writable, as a store by the process would.  The kernel calls this
+ * before writing to user memory while it holds a lock the fault handler
+ * may need.  Returns false if there is no writable page at VA. */
+bool vm_claim_page_for_write(void *va) {
+  struct thread *t = thread_current();
+  struct page *page = spt_find_page(&t->spt, va);
+  if (page == NULL || !page->writable) return false;
 
-static void hash_action_destroy(struct hash_elem *e, void *aux UNUSED) {
-  struct page *page = hash_entry(e, struct page, hash_elem);
+  if (page->frame == NULL) return vm_do_claim_page(page);
+
+  uint64_t *pte = pml4e_walk(t->pml4, (uint64_t)page->va, false);
+  if (pte != NULL && (*pte & PTE_P) && is_writable(pte)) return true;
+  return vm_handle_wp(page);
+}
+
+/* Makes the page at VA of the current process resident and privately
+ * writable, as vm_claim_page_for_write() does, and pins its frame.  A
+ * stack page that does not exist yet is created.  Returns false if VA
+ * is not writable memory of the process. */
+static bool vm_pin_page(void *va) {
   struct thread *t = thread_current();
-  if (page_get_type(page) == VM_FILE) {
-    bool mapped = pml4_get_page(t->pml4, page->va) != NULL;
-    bool dirty = mapped && pml4_is_dirty(t->pml4, page->va);
-    if (dirty && page->file.read_bytes > 0) {
-      void *kva = page->frame->kva;  // 프레임이 있다고 가정 (evict 미구현)
-      off_t ofs = page->file.ofs;
-      size_t n = page->file.read_bytes;
-      lock_acquire(&filesys_lock);
-      file_write_at(page->file.file, kva, n, ofs);
-      lock_release(&filesys_lock);
+  struct page *page = spt_find_page(&t->spt, va);
+
+  if (page == NULL) {
+    if (!is_stack_addr(va, t->user_rsp) || !vm_stack_growth(va)) return false;
+    page = spt_find_page(&t->spt, va);
+  }
+
+  // claim과 pin 사이에 evict되거나 쓰기 금지될 수 있으니 lock 안에서 확인
+  while (true) {
+    if (!vm_claim_page_for_write(va)) return false;
+
+    lock_acquire(&frame_lock);
+    struct frame *frame = page->frame;
+    uint64_t *pte = pml4e_walk(t->pml4, (uint64_t)page->va, false);
+    if (frame != NULL && pte != NULL && (*pte & PTE_P) && is_writable(pte)) {
+      frame->pin_cnt++;
+      lock_release(&frame_lock);
+      return true;
+    }
+    lock_release(&frame_lock);
+  }
+}
+
+/* Makes the user buffer of SIZE bytes at BUFFER resident and writable
+ * and pins its frames until vm_unpin_buffer(), so that the kernel can
+ * fill it while holding a lock the fault handler may need, such as
+ * filesys_lock: pinned frames are neither evicted nor write-protected by
+ * ksmd.  Returns false, pinning nothing, if part of the buffer is not
+ * writable memory of the current process. */
+bool vm_pin_buffer(void *buffer, size_t size) {
+  uint8_t *start = pg_round_down(buffer);
+  uint8_t *end = (uint8_t *)buffer + size;
+
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    if (!vm_pin_page(va)) {
+      vm_unpin_buffer(start, va - start);
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Drops the pins vm_pin_buffer() took on the buffer of SIZE bytes at
+ * BUFFER. */
+void vm_unpin_buffer(void *buffer, size_t size) {
+  struct supplemental_page_table *spt = &thread_current()->spt;
+  uint8_t *start = pg_round_down(buffer);
+  uint8_t *end = (uint8_t *)buffer + size;
+
+  lock_acquire(&frame_lock);
+  for (uint8_t *va = start; va < end; va += PGSIZE) {
+    struct page *page = spt_find_page(spt, va);
+    ASSERT(page != NULL && page->frame != NULL);
+    ASSERT(page->frame->pin_cnt > 0);
+    page->frame->pin_cnt--;
+  }
+  lock_release(&frame_lock);
+}
+
+#ifdef EFILESYS
+/* Maps file-backed PAGE to the page cache's frame of the file page it
+ * shows, reading that into the page cache first.  Returns false if PAGE
+ * has no file contents or does not fit the frame. */
+static bool frame_attach_cached(struct page *page) {
+  struct frame key;
+  if (page_get_type(page) != VM_FILE || !page_index_key(page, &key)) {
+    return false;
+  }
+
+  struct frame *cached = page_cache_hold(key.inode, key.ofs);
+  if (cached == NULL) return false;
+  bool success = frame_attach(page);
+  vm_frame_unpin(cached);
+  return success;
+}
+#endif
+
+/* Claim the PAGE and set up the mmu. */
+static bool vm_do_claim_page(struct page *page) {
+#ifdef EFILESYS
+  if (frame_attach_cached(page)) return true;
+
+  // mmap 페이지가 따로 사본을 가지면 write back이 페이지 캐시와 어긋남
+  if (page->vma != NULL && page->file.read_bytes > 0) return false;
+#endif
+  struct frame *frame = vm_get_frame();
+  if (frame == NULL) return false;
+
+  // 공유 zero page가 읽기 전용으로 매핑되어 있었을 수 있음 (TLB까지 비움)
+  pml4_clear_page(page->owner->pml4, page->va);
+
+  return vm_install_page(page, frame);
+}
+
+/* Reads PAGE, a page of the page cache, into a frame and maps it in the
+ * page cache's address space.  A SPECULATIVE read, such as read-ahead,
+ * only takes a spare frame and never evicts. */
+bool vm_claim_cache_page(struct page *page, bool speculative) {
+  struct frame *frame = speculative ? vm_get_spare_frame() : vm_get_frame();
+  if (frame == NULL) return false;
+  return vm_install_page(page, frame);
+}
+
+/* Loads PAGE into FRAME, which was pinned by vm_get_frame() or
+ * vm_get_spare_frame(), and maps it.  On failure the frame is released. */
+static bool vm_install_page(struct page *page, struct frame *frame) {
+  /* Set links */
+  lock_acquire(&frame_lock);
+  frame_link(frame, page);
+  lock_release(&frame_lock);
+
+  /* TODO: Insert page table entry to map page's VA to frame's PA. */
+  if (!swap_in(page, frame->kva)) {
+    vm_frame_unlink(page);
+    return false;
+  }
+
+  if (!pml4_set_page(page->owner->pml4, page->va, frame->kva,
+                     page->writable)) {
+    vm_frame_unlink(page);
+    return false;
+  }
+
+  lock_acquire(&frame_lock);
+  frame_publish(frame, page);
+  lock_release(&frame_lock);
+  frame_admit(frame);
+  return true;
+}
+
+/* Initialize new supplemental page table */
+void supplemental_page_table_init(struct supplemental_page_table *spt) {
+  ASSERT(spt != NULL);
+
+  // 노드는 첫 삽입 때 할당
+  spt->root = NULL;
+}
+
+/* Duplicates the initialized page P of the parent into the current
+ * process.  A resident frame is shared copy-on-write instead of copied. */
+static bool page_fork(struct page *p) {
+  struct thread *child = thread_current();
+  struct page *c = malloc(sizeof *c);
+  if (c == NULL) return false;
+
+  *c = *p;
+  c->owner = child;
+  c->frame = NULL;
+
+  if (VM_TYPE(p->operations->type) == VM_ANON) {
+    // 공유하더라도 언젠가 복사될 수 있으니 자식 몫을 예약
+    if (!vm_commit_pages(child, 1)) {
+      free(c);
+      return false;
     }
-    if (mapped) pml4_clear_page(t->pml4, page->va);
+    anon_fork(c, p);
+  } else {
+    // 자식 쪽 VMA(또는 실행 파일)의 파일 핸들을 사용
+    if (p->vma != NULL) {
+      struct vma *vma = vma_find(child, p->va);
+      if (vma == NULL) {
+        free(c);
+        return false;
+      }
+      c->vma = vma;
+      c->file.file = vma->file;
+    } else {
+      c->file.file = child->running_file;
+    }
+  }
+
+  if (!spt_insert_page(&child->spt, c)) {
+    vm_dealloc_page(c);
+    return false;
   }
-  vm_dealloc_page(page);  // destroy(page) -> free(page)
+
+  // 메모리에 있으면 frame을 공유, 아니면 fault 시 backing store에서 읽음
+  if (!vm_frame_share(p, c)) return false;
+
+  // anon_fork() 뒤에 부모 페이지가 쫓겨났으면 새로 쓰인 swap 사본을 공유.
+  // 부모는 fork가 끝날 때까지 멈춰 있으므로 다시 올라오지 않음
+  if (c->frame == NULL && VM_TYPE(p->operations->type) == VM_ANON) {
+    anon_swap_share(c, p);
+  }
+  return true;
+}
+
+/* Copy supplemental page table from src to dst.
+ * The parent's VMAs must already be copied to the current process, so
+ * that file-backed pages can refer to the child's handles. */
+bool supplemental_page_table_copy(struct supplemental_page_table *dst UNUSED,
+                                  struct supplemental_page_table *src UNUSED) {
+  struct page *p;
+  for (p = spt_find_next(src, 0); p != NULL;
+       p = spt_find_next(src, p->va + PGSIZE)) {
+    void *va = p->va;
+    bool writable = p->writable;
+
+    if (VM_TYPE(p->operations->type) == VM_UNINIT) {
+      /* 1) UNINIT Page */
+
+      struct segment_aux *aux_src = p->uninit.aux;
+      enum vm_type t = p->uninit.type;
+
+      /* aux 깊은 복사 */
+      struct segment_aux *aux_dst = malloc(sizeof *aux_dst);
+      if (aux_dst == NULL) goto fail;
+      *aux_dst = *aux_src;
+      if (aux_src->file == p->owner->running_file) {
+        aux_dst->file = thread_current()->running_file;
+      }
+
+      if (!vm_alloc_page_with_initializer(t, va, writable, p->uninit.init,
+                                          aux_dst)) {
+        free(aux_dst);
+        goto fail;
+      }
+    } else if (!page_fork(p)) {
+      /* 2) 이미 초기화된 ANON/FILE 페이지: frame을 copy-on-write로 공유 */
+      goto fail;
+    }
+  }
+
+  return true;
+
+fail:
+  supplemental_page_table_kill(dst);
+  return false;
+}
+
+/* Writes back and frees PAGE, which was already removed from the SPT. */
+static void spt_destroy_page(struct page *page) {
+  vm_dealloc_page(page);  // destroy(page)가 write-back까지 처리 -> free(page)
 }
 
 /* Free the resource hold by the supplemental page table */
@@ -439,5 +2313,17 @@ void supplemental_page_table_kill(struct supplemental_page_table *spt UNUSED) {
   /* TODO: Destroy all the supplemental_page_table hold by thread and
    * TODO: writeback all the modified contents to the storage. */
   ASSERT(spt);
-  hash_clear(&spt->page_map, hash_action_destroy);
+
+  // 주소 순서대로 페이지를 정리한 뒤 노드 해제. 이후에도 빈 SPT로 재사용 가능
+  struct page *page = spt_find_next(spt, 0);
+  while (page != NULL) {
+    void *va = page->va;
+    *spt_slot(spt, va, false) = NULL;
+    spt_destroy_page(page);
+    page = spt_find_next(spt, va + PGSIZE);
+  }
+  if (spt->root != NULL) {
+    spt_free_node(spt->root, 0);
+    spt->root = NULL;
+  }
 }
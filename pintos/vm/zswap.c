@@ -0,0 +1,304 @@
+/* zswap.c: Compressed in-memory tier in front of the swap disk.
+ *
+ * A page written to a swap slot is first compressed into a pool carved
+ * from the kernel pool, and only goes to the disk if it does not
+ * compress well or the pool is full.  The slot is still allocated on the
+ * swap disk, so reference counting and sharing of slots in anon.c work
+ * the same wherever the copy lives.
+ *
+ * The pool is divided into ZSWAP_UNIT-byte units tracked by a bitmap;
+ * each compressed page takes a run of contiguous units. */
+
+#include "vm/zswap.h"
+
+#include <debug.h>
+#include <round.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lib/kernel/bitmap.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+/* Allocation unit of the pool, in bytes. */
+#define ZSWAP_UNIT 64
+/* Largest compressed page worth keeping; anything bigger goes to disk. */
+#define ZSWAP_MAX (PGSIZE * 3 / 4)
+/* Marks a slot whose copy is not in the pool. */
+#define ZSWAP_NONE UINT32_MAX
+
+size_t zswap_pages;
+
+// 슬롯별 pool 위치
+struct zswap_entry {
+  uint32_t unit;  // 첫 unit 번호, 없으면 ZSWAP_NONE
+  uint16_t len;   // 압축된 크기 (bytes)
+};
+
+static uint8_t *zswap_pool;
+static struct bitmap *zswap_map;  // unit 사용 여부
+static struct zswap_entry *zswap_entries;
+static size_t zswap_slot_cnt;
+static size_t zswap_units_used;
+static struct lock zswap_lock;
+
+// 압축 작업 공간. zswap_lock으로 보호
+static uint8_t zswap_buf[ZSWAP_MAX];
+
+// 통계
+static uint64_t zswap_stores;         // pool에 저장한 페이지 수
+static uint64_t zswap_incompressible; // 압축이 잘 안 되어 disk로 간 수
+static uint64_t zswap_full;           // pool이 가득 차서 disk로 간 수
+static uint64_t zswap_hits;           // pool에서 읽은 swap-in 수
+static uint64_t zswap_misses;         // disk에서 읽은 swap-in 수
+static uint64_t zswap_stored_bytes;   // 저장한 페이지의 압축 후 크기 합
+
+/* Initializes the pool for a swap disk of SLOT_CNT slots. */
+void zswap_init(size_t slot_cnt) {
+  if (zswap_pages == 0 || slot_cnt == 0) return;
+
+  zswap_pool = palloc_get_multiple(0, zswap_pages);
+  zswap_map = bitmap_create(zswap_pages * (PGSIZE / ZSWAP_UNIT));
+  zswap_entries = malloc(slot_cnt * sizeof *zswap_entries);
+  if (zswap_pool == NULL || zswap_map == NULL || zswap_entries == NULL) {
+    PANIC("zswap pool allocation failed");
+  }
+  for (size_t i = 0; i < slot_cnt; i++) {
+    zswap_entries[i].unit = ZSWAP_NONE;
+  }
+  zswap_slot_cnt = slot_cnt;
+  lock_init(&zswap_lock);
+}
+
+/* LZ77 codec in the LZ4 block layout.  A sequence is a token byte whose
+ * high nibble is the literal count and low nibble the match length minus
+ * LZ_MIN_MATCH, the literals, and a 16-bit little-endian match offset.
+ * A nibble of 15 is continued by bytes added to it, up to a byte below
+ * 255.  The last sequence has literals only. */
+#define LZ_MIN_MATCH 4
+#define LZ_HASH_BITS 10
+
+// 4바이트 열 → 마지막으로 본 위치
+static uint16_t lz_table[1 << LZ_HASH_BITS];
+
+static unsigned lz_hash(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof v);
+  return (v * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Appends the continuation bytes of length N, whose nibble was 15. */
+static bool lz_put_len(uint8_t *dst, size_t *op, size_t limit, size_t n) {
+  for (;;) {
+    if (*op >= limit) return false;
+    if (n < 255) {
+      dst[(*op)++] = n;
+      return true;
+    }
+    dst[(*op)++] = 255;
+    n -= 255;
+  }
+}
+
+/* Appends a sequence of LIT_CNT literals from LIT, followed by a match of
+ * MATCH_LEN bytes at OFFSET unless MATCH_LEN is 0.  Returns false if the
+ * output would pass LIMIT. */
+static bool lz_emit(uint8_t *dst, size_t *op, size_t limit, const uint8_t *lit,
+                    size_t lit_cnt, size_t offset, size_t match_len) {
+  size_t lit_nib = lit_cnt < 15 ? lit_cnt : 15;
+  size_t match_nib = 0;
+
+  if (match_len > 0) {
+    match_nib = match_len - LZ_MIN_MATCH;
+    if (match_nib > 15) match_nib = 15;
+  }
+  if (*op >= limit) return false;
+  dst[(*op)++] = lit_nib << 4 | match_nib;
+  if (lit_nib == 15 && !lz_put_len(dst, op, limit, lit_cnt - 15)) return false;
+
+  if (lit_cnt > limit - *op) return false;
+  memcpy(dst + *op, lit, lit_cnt);
+  *op += lit_cnt;
+
+  if (match_len == 0) return true;
+  if (limit - *op < 2) return false;
+  dst[(*op)++] = offset & 0xff;
+  dst[(*op)++] = offset >> 8;
+  if (match_nib == 15 &&
+      !lz_put_len(dst, op, limit, match_len - LZ_MIN_MATCH - 15)) {
+    return false;
+  }
+  return true;
+}
+
+/* Compresses the page at SRC into DST.  Returns the compressed size, or 0
+ * if it would exceed LIMIT bytes. */
+static size_t lz_compress(const uint8_t *src, uint8_t *dst, size_t limit) {
+  size_t ip = 0, anchor = 0, op = 0;
+
+  memset(lz_table, 0, sizeof lz_table);
+  while (ip + LZ_MIN_MATCH <= PGSIZE) {
+    unsigned h = lz_hash(src + ip);
+    size_t ref = lz_table[h];
+    lz_table[h] = ip;
+
+    if (ref < ip && memcmp(src + ref, src + ip, LZ_MIN_MATCH) == 0) {
+      size_t len = LZ_MIN_MATCH;
+      while (ip + len < PGSIZE && src[ref + len] == src[ip + len]) len++;
+      if (!lz_emit(dst, &op, limit, src + anchor, ip - anchor, ip - ref, len))
+        return 0;
+      ip += len;
+      anchor = ip;
+    } else {
+      ip++;
+    }
+  }
+  if (!lz_emit(dst, &op, limit, src + anchor, PGSIZE - anchor, 0, 0)) return 0;
+  return op;
+}
+
+/* Reads the continuation bytes of a length whose nibble was 15. */
+static bool lz_get_len(const uint8_t *src, size_t *ip, size_t len,
+                       size_t *n) {
+  uint8_t b;
+  do {
+    if (*ip >= len) return false;
+    b = src[(*ip)++];
+    *n += b;
+  } while (b == 255);
+  return true;
+}
+
+/* Decompresses LEN bytes at SRC into the page at DST.  Returns false if
+ * the input is corrupt. */
+static bool lz_decompress(const uint8_t *src, size_t len, uint8_t *dst) {
+  size_t ip = 0, op = 0;
+
+  while (ip < len) {
+    uint8_t token = src[ip++];
+    size_t lit_cnt = token >> 4;
+    if (lit_cnt == 15 && !lz_get_len(src, &ip, len, &lit_cnt)) return false;
+    if (lit_cnt > len - ip || lit_cnt > PGSIZE - op) return false;
+    memcpy(dst + op, src + ip, lit_cnt);
+    ip += lit_cnt;
+    op += lit_cnt;
+    if (ip == len) break;
+
+    if (len - ip < 2) return false;
+    size_t offset = src[ip] | src[ip + 1] << 8;
+    ip += 2;
+    size_t match_len = (token & 15) + LZ_MIN_MATCH;
+    if ((token & 15) == 15 && !lz_get_len(src, &ip, len, &match_len))
+      return false;
+    if (offset == 0 || offset > op || match_len > PGSIZE - op) return false;
+
+    // 겹칠 수 있으므로 한 바이트씩 복사
+    for (size_t i = 0; i < match_len; i++) dst[op + i] = dst[op - offset + i];
+    op += match_len;
+  }
+  return op == PGSIZE;
+}
+
+/* Frees SLOT's pool copy, if any.  Must be called with zswap_lock held. */
+static void zswap_release(size_t slot) {
+  struct zswap_entry *e = &zswap_entries[slot];
+  size_t units = DIV_ROUND_UP(e->len, ZSWAP_UNIT);
+
+  if (e->unit == ZSWAP_NONE) return;
+  bitmap_set_multiple(zswap_map, e->unit, units, false);
+  zswap_units_used -= units;
+  e->unit = ZSWAP_NONE;
+}
+
+/* Stores the page at KVA as the copy of swap slot SLOT, replacing any
+ * copy already in the pool.  Returns false if the caller must write it
+ * to disk instead. */
+bool zswap_store(size_t slot, const void *kva) {
+  if (zswap_pool == NULL) return false;
+  ASSERT(slot < zswap_slot_cnt);
+
+  lock_acquire(&zswap_lock);
+  zswap_release(slot);
+
+  size_t len = lz_compress(kva, zswap_buf, ZSWAP_MAX);
+  if (len == 0) {
+    zswap_incompressible++;
+    lock_release(&zswap_lock);
+    return false;
+  }
+
+  size_t units = DIV_ROUND_UP(len, ZSWAP_UNIT);
+  size_t unit = bitmap_scan_and_flip(zswap_map, 0, units, false);
+  if (unit == BITMAP_ERROR) {
+    zswap_full++;
+    lock_release(&zswap_lock);
+    return false;
+  }
+
+  memcpy(zswap_pool + unit * ZSWAP_UNIT, zswap_buf, len);
+  zswap_entries[slot].unit = unit;
+  zswap_entries[slot].len = len;
+  zswap_units_used += units;
+  zswap_stores++;
+  zswap_stored_bytes += len;
+  lock_release(&zswap_lock);
+  return true;
+}
+
+/* Reads swap slot SLOT into KVA if its copy is in the pool.  The copy
+ * stays there, like the swap cache keeps disk slots.  Returns false if
+ * the copy is on disk. */
+bool zswap_load(size_t slot, void *kva) {
+  if (zswap_pool == NULL) return false;
+
+  lock_acquire(&zswap_lock);
+  struct zswap_entry *e = &zswap_entries[slot];
+  if (e->unit == ZSWAP_NONE) {
+    zswap_misses++;
+    lock_release(&zswap_lock);
+    return false;
+  }
+  if (!lz_decompress(zswap_pool + e->unit * ZSWAP_UNIT, e->len, kva)) {
+    PANIC("zswap: corrupt copy of slot %zu", slot);
+  }
+  zswap_hits++;
+  lock_release(&zswap_lock);
+  return true;
+}
+
+/* True if swap slot SLOT's copy is in the pool rather than on disk. */
+bool zswap_holds(size_t slot) {
+  if (zswap_pool == NULL) return false;
+
+  lock_acquire(&zswap_lock);
+  bool held = zswap_entries[slot].unit != ZSWAP_NONE;
+  lock_release(&zswap_lock);
+  return held;
+}
+
+/* Drops the pool copy of SLOT, which has been freed. */
+void zswap_drop(size_t slot) {
+  if (zswap_pool == NULL) return;
+
+  lock_acquire(&zswap_lock);
+  zswap_release(slot);
+  lock_release(&zswap_lock);
+}
+
+/* Prints compressed swap statistics. */
+void zswap_print_stats(void) {
+  if (zswap_pool == NULL) return;
+
+  uint64_t ratio =
+      zswap_stored_bytes ? zswap_stores * PGSIZE * 100 / zswap_stored_bytes : 0;
+  printf("Zswap: %llu stored, %llu incompressible, %llu pool full; "
+         "%llu hits, %llu misses\n",
+         zswap_stores, zswap_incompressible, zswap_full, zswap_hits,
+         zswap_misses);
+  printf("Zswap pool: %zu of %zu KiB used, compression ratio %llu.%02llu\n",
+         zswap_units_used * ZSWAP_UNIT / 1024, zswap_pages * PGSIZE / 1024,
+         ratio / 100, ratio % 100);
+}